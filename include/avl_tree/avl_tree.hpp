@@ -5,27 +5,69 @@
 #include <iostream>
 #include <stack>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 #include "../compare.hpp"
+#include "../counting.hpp"
+#include "../memory_usage.hpp"
+#include "../slab_allocator.hpp"
+#include "../statistics.hpp"
 #include "node.hpp"
 
 using namespace icu;
 
-template <typename key_t, typename value_t, typename compare = std::less<key_t>>
+// Árvore AVL. A política allocator define de onde os nós são alocados
+// (slab_allocator por padrão, ou heap_allocator para um new por nó) e a
+// política counting define se as operações são contadas
+template <typename key_t, typename value_t, typename compare = std::less<key_t>,
+          typename allocator = slab_allocator,
+          typename counting = default_counting_policy>
 class avl_tree {
    private:
+    using node_pool = typename allocator::template pool<node<key_t, value_t>>;
+
+    // Tamanho do caminho de descida guardado na pilha. A altura de uma árvore
+    // AVL com n nós é menor que 1.45 * log2(n + 2), ou seja, menor que 48
+    // para qualquer número de nós que caiba em unsigned int
+    static constexpr int max_height = 64;
+
     node<key_t, value_t>* _root = nullptr;  // Raiz da árvore
     unsigned int _size = 0;                 // Número de nós na árvore
     compare _compare;                       // Functor de comparação
-    unsigned int _comparisons = 0;          // Número de comparações feitas
+    counting _counters;                     // Contadores de operações
+    node_pool _pool;                        // Pool de onde os nós são alocados
+
+    // Compara duas chaves com o functor de comparação, contando a comparação
+    bool _less(const key_t& a, const key_t& b) {
+        _counters.comparison();
+        return _compare(a, b);
+    }
 
+    // Destrói os nós da subárvore de n. Se o pool libera a memória de uma vez,
+    // apenas os destrutores são chamados aqui
     void _clear(node<key_t, value_t>* n) {
         if (n == nullptr) {
             return;
         }
         _clear(n->left);
         _clear(n->right);
-        delete n;
+        if constexpr (node_pool::bulk_release) {
+            n->~node();
+        } else {
+            _pool.destroy(n);
+        }
+    }
+
+    // Destrói todos os nós da árvore e libera a memória do pool. Nós com
+    // chave e valor triviais nem precisam ser percorridos
+    void _release() {
+        if constexpr (!node_pool::bulk_release ||
+                      !std::is_trivially_destructible<
+                          node<key_t, value_t>>::value) {
+            _clear(_root);
+        }
+        _pool.release();
     }
 
     int _height(node<key_t, value_t>* n) const {
@@ -40,6 +82,7 @@ class avl_tree {
     }
 
     node<key_t, value_t>* _right_rotation(node<key_t, value_t>* p) {
+        _counters.rotation();
         node<key_t, value_t>* u = p->left;
         p->left = u->right;
         u->right = p;
@@ -51,6 +94,7 @@ class avl_tree {
     }
 
     node<key_t, value_t>* _left_rotation(node<key_t, value_t>* p) {
+        _counters.rotation();
         node<key_t, value_t>* u = p->right;
         p->right = u->left;
         u->left = p;
@@ -61,167 +105,232 @@ class avl_tree {
         return u;
     }
 
-    node<key_t, value_t>* _insert(node<key_t, value_t>* p, key_t k, value_t v) {
-        _comparisons++;
-        if (p == nullptr) {
-            _size++;
-            return new node<key_t, value_t>(k, v);
-        }
-
-        _comparisons++;
-        if (_compare(k, p->key.first)) {
-            p->left = _insert(p->left, k, v);
-        } else if (_compare(p->key.first, k)) {
-            _comparisons++;
-            p->right = _insert(p->right, k, v);
-        } else {
-            return p;
-        }
-
-        p = _fixup_node(p, k);
-        return p;
-    }
-
-    node<key_t, value_t>* _fixup_node(node<key_t, value_t>* p, key_t k) {
-        p->height = 1 + std::max(_height(p->left), _height(p->right));
+    // Atualiza a altura de n e o rebalanceia caso necessário, retornando a
+    // nova raiz da subárvore (decide as rotações pelos fatores de balanço,
+    // sem comparar chaves)
+    node<key_t, value_t>* _rebalance(node<key_t, value_t>* n) {
+        n->height = 1 + std::max(_height(n->left), _height(n->right));
 
-        int bal = _balance(p);
+        int bal = _balance(n);
 
-        _comparisons++;
-        if (bal < -1 && _compare(k, p->left->key.first)) {
-            return _right_rotation(p);
+        if (bal > 1) {
+            if (_balance(n->right) < 0) {
+                n->right = _right_rotation(n->right);
+            }
+            return _left_rotation(n);
         }
 
-        _comparisons++;
-        if (bal < -1 && _compare(p->left->key.first, k)) {
-            p->left = _left_rotation(p->left);
-            return _right_rotation(p);
+        if (bal < -1) {
+            if (_balance(n->left) > 0) {
+                n->left = _left_rotation(n->left);
+            }
+            return _right_rotation(n);
         }
 
-        _comparisons++;
-        if (bal > 1 && _compare(p->right->key.first, k)) {
-            return _left_rotation(p);
-        }
+        return n;
+    }
 
-        _comparisons++;
-        if (bal > 1 && _compare(k, p->right->key.first)) {
-            p->right = _right_rotation(p->right);
-            return _left_rotation(p);
+    // Rebalanceia de baixo para cima os nós apontados pelos elos do caminho
+    // de descida. Para assim que a altura de uma subárvore não muda, pois os
+    // nós acima dela não são afetados
+    void _rebalance_path(node<key_t, value_t>** path[], int depth) {
+        while (depth > 0) {
+            node<key_t, value_t>** link = path[--depth];
+            int old_height = (*link)->height;
+            *link = _rebalance(*link);
+            if ((*link)->height == old_height) {
+                break;
+            }
         }
-
-        return p;
     }
 
-    node<key_t, value_t>* _remove(node<key_t, value_t>* n, key_t k) {
-        _comparisons++;
-        if (n == nullptr) {
-            return nullptr;
+    // Insere a chave k (caso não exista) e retorna o nó que contém a chave,
+    // seja ele o nó recém-criado ou o nó já existente. A descida é iterativa
+    // e guarda no caminho os elos percorridos; a chave só é copiada (ou
+    // movida) para o novo nó
+    template <typename key_arg, typename value_arg>
+    node<key_t, value_t>* _insert(key_arg&& k, value_arg&& v) {
+        node<key_t, value_t>** path[max_height];
+        int depth = 0;
+        node<key_t, value_t>** link = &_root;
+
+        while (*link != nullptr) {
+            node<key_t, value_t>* p = *link;
+            if (_less(k, p->key.first)) {
+                path[depth++] = link;
+                link = &p->left;
+            } else if (_less(p->key.first, k)) {
+                path[depth++] = link;
+                link = &p->right;
+            } else {
+                return p;  // A chave já existe
+            }
         }
 
-        if (_compare(k, n->key.first)) {
-            n->left = _remove(n->left, k);
-        } else if (_compare(n->key.first, k)) {
-            _comparisons++;
-            n->right = _remove(n->right, k);
-        } else if (n->right == nullptr) {
-            _comparisons++;
-            node<key_t, value_t>* temp = n->left;
-            delete n;
-            _size--;
-            return temp;
-        } else {
-            n->right = _remove_successor(n, n->right);
-            _size--;
-        }
+        node<key_t, value_t>* result =
+            _pool.create(std::forward<key_arg>(k), std::forward<value_arg>(v));
+        *link = result;
+        _size++;
 
-        n = _fixup_deletion(n);
-        return n;
+        _rebalance_path(path, depth);
+        return result;
     }
 
-    node<key_t, value_t>* _remove_successor(node<key_t, value_t>* n,
-                                            node<key_t, value_t>* successor) {
-        _comparisons++;
-        if (successor->left != nullptr) {
-            successor->left = _remove_successor(n, successor->left);
-        } else {
-            n->key = successor->key;
-            node<key_t, value_t>* temp = successor->right;
-            delete successor;
-            return temp;
+    // Remove a chave k (caso exista), com descida iterativa. Um nó com dois
+    // filhos recebe o par do seu sucessor, que é então removido
+    bool _remove(const key_t& k) {
+        node<key_t, value_t>** path[max_height];
+        int depth = 0;
+        node<key_t, value_t>** link = &_root;
+
+        while (*link != nullptr) {
+            node<key_t, value_t>* p = *link;
+            if (_less(k, p->key.first)) {
+                path[depth++] = link;
+                link = &p->left;
+            } else if (_less(p->key.first, k)) {
+                path[depth++] = link;
+                link = &p->right;
+            } else {
+                break;
+            }
         }
-        successor = _fixup_deletion(successor);
-        return successor;
-    }
 
-    node<key_t, value_t>* _fixup_deletion(node<key_t, value_t>* n) {
-        _comparisons++;
-        if (n == nullptr) {
-            return nullptr;
+        if (*link == nullptr) {
+            return false;  // Chave não encontrada
         }
 
-        n->height = 1 + std::max(_height(n->left), _height(n->right));
-
-        int bal = _balance(n);
-
-        if (bal > 1 && _balance(n->right) >= 0) {
-            return _left_rotation(n);
-        }
+        node<key_t, value_t>* n = *link;
+        if (n->right == nullptr) {
+            *link = n->left;
+            _pool.destroy(n);
+        } else {
+            // Desce até o sucessor (menor nó da subárvore direita)
+            path[depth++] = link;
+            node<key_t, value_t>** successor = &n->right;
+            while ((*successor)->left != nullptr) {
+                path[depth++] = successor;
+                successor = &(*successor)->left;
+            }
 
-        if (bal > 1 && _balance(n->right) < 0) {
-            n->right = _right_rotation(n->right);
-            return _left_rotation(n);
+            node<key_t, value_t>* s = *successor;
+            *successor = s->right;
+            n->key = std::move(s->key);
+            _pool.destroy(s);
         }
+        _size--;
 
-        if (bal < -1 && _balance(n->left) <= 0) {
-            return _right_rotation(n);
-        }
+        _rebalance_path(path, depth);
+        return true;
+    }
 
-        if (bal < -1 && _balance(n->left) > 0) {
-            n->left = _left_rotation(n->left);
-            return _right_rotation(n);
+    node<key_t, value_t>* _search(node<key_t, value_t>* n, const key_t& k) {
+        while (n != nullptr) {
+            if (_less(k, n->key.first)) {
+                n = n->left;
+            } else if (_less(n->key.first, k)) {
+                n = n->right;
+            } else {
+                return n;
+            }
         }
-
-        return n;
+        return nullptr;
     }
 
-    node<key_t, value_t>* _search(node<key_t, value_t>* n, key_t k) {
-        _comparisons++;
+    // Percorre a subárvore de n em ordem, chamando f(chave, valor)
+    template <typename function>
+    void _for_each(node<key_t, value_t>* n, function& f) const {
         if (n == nullptr) {
-            return nullptr;
+            return;
         }
+        _for_each(n->left, f);
+        f(n->key.first, n->key.second);
+        _for_each(n->right, f);
+    }
 
-        _comparisons++;
-        if (!_compare(k, n->key.first) && !_compare(n->key.first, k)) {
-            return n;
+    // Registra no histograma h a profundidade de cada nó da subárvore de n
+    void _depths(node<key_t, value_t>* n, size_t depth, histogram& h) const {
+        if (n == nullptr) {
+            return;
         }
+        h.add(depth);
+        _depths(n->left, depth + 1, h);
+        _depths(n->right, depth + 1, h);
+    }
 
-        _comparisons++;
-        if (_compare(k, n->key.first)) {
-            return _search(n->left, k);
+    // Monta uma subárvore balanceada com os pares [first, last), já em ordem
+    // crescente: o par do meio é a raiz e cada metade forma uma subárvore
+    template <typename iterator_t>
+    node<key_t, value_t>* _build(iterator_t first, iterator_t last) {
+        if (first == last) {
+            return nullptr;
         }
-        return _search(n->right, k);
+        iterator_t middle = first + (last - first) / 2;
+        node<key_t, value_t>* n = _pool.create(middle->first, middle->second);
+        n->left = _build(first, middle);
+        n->right = _build(middle + 1, last);
+        n->height = 1 + std::max(_height(n->left), _height(n->right));
+        return n;
     }
 
    public:
+    using key_type = key_t;       // Tipo das chaves
+    using mapped_type = value_t;  // Tipo dos valores
+    using key_compare = compare;  // Ordem das chaves
+
     // Construtor da árvore
     avl_tree() : _compare(compare()) {}
 
     // Destruidor da árvore
-    ~avl_tree() { _clear(_root); }
+    ~avl_tree() { _release(); }
 
     // Insere uma chave e valor na árvore
-    void insert(key_t k, value_t v) { _root = _insert(_root, k, v); }
+    void insert(const key_t& k, const value_t& v) { _insert(k, v); }
+
+    // Insere uma chave e valor na árvore, movendo a chave para o novo nó
+    void insert(key_t&& k, const value_t& v) { _insert(std::move(k), v); }
+
+    // Constrói o par (chave, valor) a partir de args e o insere na árvore,
+    // movendo a chave e o valor para o novo nó. Retorna se houve inserção
+    template <typename... args_t>
+    bool emplace(args_t&&... args) {
+        std::pair<key_t, value_t> p(std::forward<args_t>(args)...);
+        unsigned int old_size = _size;
+        _insert(std::move(p.first), std::move(p.second));
+        return _size != old_size;
+    }
+
+    // Retorna a referência para o valor associado a uma chave, inserindo a
+    // chave com o valor v caso ela não exista (uma única descida na árvore)
+    value_t& find_or_insert(const key_t& k, const value_t& v) {
+        return _insert(k, v)->key.second;
+    }
+
+    // Igual a find_or_insert, mas move a chave para o novo nó (se criado)
+    value_t& find_or_insert(key_t&& k, const value_t& v) {
+        return _insert(std::move(k), v)->key.second;
+    }
 
     // Remove uma chave da árvore
-    void remove(key_t k) { _root = _remove(_root, k); }
+    void remove(const key_t& k) { _remove(k); }
 
     // Limpa a árvore
     void clear() {
-        _clear(_root);
+        _release();
         _root = nullptr;
         _size = 0;
     }
 
+    // Substitui o conteúdo da árvore pelos pares [first, last), que devem
+    // estar em ordem estritamente crescente de chave. A árvore é montada já
+    // balanceada em O(n), sem comparações nem rotações
+    template <typename iterator_t>
+    void assign_sorted(iterator_t first, iterator_t last) {
+        clear();
+        _root = _build(first, last);
+        _size = static_cast<unsigned int>(last - first);
+    }
+
     // Retorna o número de nós na árvore
     unsigned int size() const { return _size; }
 
@@ -229,9 +338,8 @@ class avl_tree {
     bool empty() const { return _size == 0; }
 
     // Retorna a referência para o valor associado a uma chave
-    value_t& search(key_t k) {
+    value_t& search(const key_t& k) {
         node<key_t, value_t>* n = _search(_root, k);
-        _comparisons++;
         if (n != nullptr) {
             return n->key.second;
         }
@@ -239,14 +347,23 @@ class avl_tree {
         throw std::out_of_range("Key not found");
     }
 
+    // Retorna um ponteiro para o valor associado a uma chave, ou nullptr caso a
+    // chave não exista
+    value_t* find(const key_t& k) {
+        node<key_t, value_t>* n = _search(_root, k);
+        if (n != nullptr) {
+            return &n->key.second;
+        }
+        return nullptr;
+    }
+
     // Verifica se uma chave está na árvore
-    bool contains(key_t k) { return _search(_root, k) != nullptr; }
+    bool contains(const key_t& k) { return _search(_root, k) != nullptr; }
 
     // Atualiza o valor associado a uma chave
-    void att(key_t k, value_t v) {
+    void att(const key_t& k, const value_t& v) {
         node<key_t, value_t>* n = _search(_root, k);
 
-        _comparisons++;
         if (n != nullptr) {
             n->key.second = v;
             return;
@@ -255,6 +372,12 @@ class avl_tree {
         throw std::out_of_range("Key not found");
     }
 
+    // Percorre todos os pares da árvore em ordem, chamando f(chave, valor)
+    template <typename function>
+    void for_each(function f) const {
+        _for_each(_root, f);
+    }
+
     // Classe iterador
     class iterator {
        private:
@@ -312,6 +435,32 @@ class avl_tree {
 
     iterator end() { return iterator(nullptr); }
 
-    // Retorna o número de comparações realizadas
-    unsigned int comparisons() const { return _comparisons; }
+    // Retorna os contadores de operações
+    const counting& counters() const { return _counters; }
+
+    // Retorna a memória usada pela árvore, separada por categoria
+    memory_breakdown memory_usage() const {
+        memory_breakdown usage;
+        usage.nodes = _size * sizeof(node<key_t, value_t>);
+        for_each([&usage](const key_t& k, const value_t& v) {
+            usage.key_heap += heap_bytes(k) + heap_bytes(v);
+        });
+        usage.slack =
+            _pool.reserved_bytes() - _size * sizeof(node<key_t, value_t>);
+        return usage;
+    }
+
+    // Retorna as estatísticas de forma da árvore: o histograma da
+    // profundidade dos nós (a raiz tem profundidade 0) e, com a contagem
+    // habilitada, o número de rotações
+    structure_stats stats() const {
+        structure_stats s;
+        if constexpr (counting::enabled) {
+            s.values.push_back({"rotações", _counters.rotations});
+        }
+        histogram depths;
+        _depths(_root, 0, depths);
+        s.histograms.push_back({"profundidade dos nós", depths});
+        return s;
+    }
 };
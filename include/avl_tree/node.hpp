@@ -9,5 +9,8 @@ struct node {
     int height;
 
     node(key_t k, value_t v)
-        : key(std::make_pair(k, v)), left(nullptr), right(nullptr), height(1) {}
+        : key(std::move(k), std::move(v)),
+          left(nullptr),
+          right(nullptr),
+          height(1) {}
 };
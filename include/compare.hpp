@@ -2,13 +2,30 @@
 #include <unicode/coll.h>
 #include <unicode/unistr.h>
 
-// Functor para comparar strings Unicode usando ICU Collator
+#include <memory>
+#include <string>
+
+#include "memory_usage.hpp"
+
+// Functor para comparar strings Unicode usando ICU Collator. Cada cópia do
+// functor possui o seu próprio Collator (clonado), pois um mesmo Collator não
+// pode ser usado por várias threads ao mesmo tempo
 struct unicode_compare {
-    icu::Collator *collator;
+    std::unique_ptr<icu::Collator> collator;
 
     unicode_compare() {
         UErrorCode status = U_ZERO_ERROR;
-        collator = icu::Collator::createInstance(status);
+        collator.reset(icu::Collator::createInstance(status));
+    }
+
+    unicode_compare(const unicode_compare &other)
+        : collator(other.collator->clone()) {}
+
+    unicode_compare &operator=(const unicode_compare &other) {
+        if (this != &other) {
+            collator.reset(other.collator->clone());
+        }
+        return *this;
     }
 
     bool operator()(const icu::UnicodeString &lhs,
@@ -16,6 +33,62 @@ struct unicode_compare {
         UErrorCode status = U_ZERO_ERROR;
         return collator->compare(lhs, rhs, status) < 0;
     }
+};
+
+// Chave das estruturas formada por uma palavra e pela sua chave de ordenação
+// (sort key) do ICU Collator. A sort key é calculada pelo sort_key_compare na
+// primeira vez em que a chave é comparada e fica guardada junto da palavra,
+// inclusive nas cópias feitas ao inserir a chave em uma estrutura
+struct collation_key {
+    icu::UnicodeString word;       // Palavra
+    mutable std::string sort_key;  // Sort key (vazia enquanto não calculada)
+
+    collation_key() {}
+
+    collation_key(const icu::UnicodeString &w) : word(w) {}
+
+    // Permite usar a chave onde se espera a palavra (hash, listagem)
+    operator const icu::UnicodeString &() const { return word; }
 
-    ~unicode_compare() { delete collator; }
+    // Igualdade considera apenas a palavra
+    bool operator==(const collation_key &other) const {
+        return word == other.word;
+    }
+
+    bool operator!=(const collation_key &other) const {
+        return word != other.word;
+    }
+};
+
+// Memória na heap de uma collation_key: a da palavra mais a da sort key
+inline size_t heap_bytes(const collation_key &k) {
+    return heap_bytes(k.word) + heap_bytes(k.sort_key);
+}
+
+// Functor para comparar collation_keys pelas suas sort keys. Cada sort key é
+// calculada uma única vez com Collator::getSortKey e as comparações seguintes
+// são comparações de bytes (memcmp), equivalentes a Collator::compare
+struct sort_key_compare : unicode_compare {
+    // Retorna a sort key da chave, calculando-a caso ainda não exista
+    const std::string &sort_key(const collation_key &k) const {
+        if (k.sort_key.empty()) {
+            // A sort key termina com um byte zero, que não é guardado
+            int32_t capacity = 4 * k.word.length() + 16;
+            k.sort_key.resize(capacity);
+            int32_t length = collator->getSortKey(
+                k.word, reinterpret_cast<uint8_t *>(&k.sort_key[0]), capacity);
+            if (length > capacity) {
+                k.sort_key.resize(length);
+                collator->getSortKey(
+                    k.word, reinterpret_cast<uint8_t *>(&k.sort_key[0]),
+                    length);
+            }
+            k.sort_key.resize(length - 1);
+        }
+        return k.sort_key;
+    }
+
+    bool operator()(const collation_key &lhs, const collation_key &rhs) const {
+        return sort_key(lhs) < sort_key(rhs);
+    }
 };
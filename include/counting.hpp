@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+// Políticas de contagem de operações, usadas como parâmetro de template pelas
+// estruturas de dados. Com no_counting_policy as chamadas de contagem são
+// vazias e o compilador as elimina; com counting_policy cada categoria tem
+// seu próprio contador de 64 bits.
+
+// Conta as operações, separadas por categoria
+struct counting_policy {
+    static constexpr bool enabled = true;
+
+    uint64_t key_comparisons = 0;  // Comparações entre chaves
+    uint64_t probes = 0;           // Posições visitadas nas tabelas hash
+    uint64_t rotations = 0;        // Rotações nas árvores
+    uint64_t rehash_moves = 0;     // Elementos movidos nos rehash
+    uint64_t recolors = 0;         // Trocas de cor na árvore rubro-negra
+
+    void comparison() { key_comparisons++; }
+    void probe() { probes++; }
+    void rotation() { rotations++; }
+    void rehash_move() { rehash_moves++; }
+    void recolor() { recolors++; }
+};
+
+// Não conta nenhuma operação
+struct no_counting_policy {
+    static constexpr bool enabled = false;
+
+    static constexpr uint64_t key_comparisons = 0;
+    static constexpr uint64_t probes = 0;
+    static constexpr uint64_t rotations = 0;
+    static constexpr uint64_t rehash_moves = 0;
+    static constexpr uint64_t recolors = 0;
+
+    void comparison() {}
+    void probe() {}
+    void rotation() {}
+    void rehash_move() {}
+    void recolor() {}
+};
+
+// Política usada por padrão pelas estruturas: a contagem só é compilada
+// quando a macro COUNT_OPERATIONS está definida (-DCOUNT_OPERATIONS)
+#ifdef COUNT_OPERATIONS
+using default_counting_policy = counting_policy;
+#else
+using default_counting_policy = no_counting_policy;
+#endif
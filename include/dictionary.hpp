@@ -5,66 +5,189 @@
 #include <unicode/unistr.h>
 #include <unicode/ustream.h>
 
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "../src/utils.cpp"
+#include "interned_word.hpp"
+#include "memory_usage.hpp"
+#include "output_writer.hpp"
+#include "phase_timer.hpp"
+#include "snapshot.hpp"
+#include "statistics.hpp"
+#include "tokenizer.hpp"
 
 // Dicionário de palavras, template é o tipo de estrutura de dados que será
 // utilizada para armazenar as palavras.
 template <typename type>
 class dictionary {
    private:
-    type _dict;  // Dicionário
+    using key_type = typename type::key_type;
+    using key_compare = typename type::key_compare;
+
+    // Indica se a estrutura guarda as palavras internadas em uma arena
+    static constexpr bool _interned =
+        std::is_same<key_type, interned_word>::value;
+
+    // Desfaz na arena, ao sair do escopo, uma palavra internada apenas para
+    // uma busca
+    struct rollback_guard {
+        word_arena& arena;
+        const interned_word& key;
+        ~rollback_guard() { arena.rollback(key); }
+    };
+
+    word_arena _arena;  // Arena das palavras (apenas com palavras internadas)
+    type _dict;         // Dicionário
+
+    // Soma count à frequência da palavra (uma única busca na estrutura). Uma
+    // palavra internada é adicionada à arena antes da busca e desfeita caso
+    // já estivesse na estrutura
+    template <typename word_t>
+    void _add(const word_t& word, int count) {
+        if constexpr (_interned) {
+            interned_word key = _arena.intern(word);
+            size_t old_size = _dict.size();
+            _dict.find_or_insert(key, 0) += count;
+            if (_dict.size() == old_size) {
+                _arena.rollback(key);
+            }
+        } else {
+            _dict.find_or_insert(word, 0) += count;
+        }
+    }
+
+    // Escreve no arquivo o cabeçalho seguido das palavras de entries (pares
+    // palavra e frequência), no mesmo formato de list(). Cada palavra é
+    // codificada em UTF-8 direto no buffer do buffered_writer, sem montar a
+    // listagem inteira em memória
+    template <typename range_t>
+    void _write_list(const std::string& filename, const std::string& header,
+                     range_t& entries) {
+        buffered_writer output_file(filename);
+        if (!output_file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            exit(1);
+        }
+
+        output_file.write(header);
+        for (const auto& pair : entries) {
+            const icu::UnicodeString& word = pair.first;
+            output_file.write('"');
+            output_file.write_utf16(word.getBuffer(), word.length());
+            output_file.write("\" - ", 4);
+            output_file.write(static_cast<long long>(pair.second));
+            output_file.write('\n');
+        }
+
+        if (!output_file.close()) {
+            std::cerr << "Error: Could not write file " << filename
+                      << std::endl;
+            exit(1);
+        }
+    }
+
+    // Retorna a chave da estrutura para uma palavra em UTF-16. A palavra
+    // internada é adicionada à arena sem buscas (a palavra ainda não está na
+    // estrutura)
+    key_type _make_key(const std::u16string& word) {
+        if constexpr (_interned) {
+            return _arena.intern(word.data(), word.size());
+        } else {
+            return key_type(icu::UnicodeString(word.data(), word.size()));
+        }
+    }
+
+    // Encerra o programa caso o snapshot seja inválido
+    static void _check_snapshot(const snapshot_view& snapshot,
+                                const std::string& filename) {
+        if (!snapshot.is_valid()) {
+            std::cerr << "Error: Invalid snapshot " << filename << " ("
+                      << snapshot.error() << ")" << std::endl;
+            exit(1);
+        }
+    }
+
+    // Soma ao dicionário as palavras do snapshot uma a uma, com uma busca na
+    // estrutura por palavra. Usado quando o snapshot foi ordenado com outras
+    // regras de colação, e a sua ordem não pode ser usada
+    void _add_snapshot(const snapshot_view& snapshot) {
+        std::u16string word;
+        for (size_t i = 0; i < snapshot.size(); i++) {
+            snapshot.word_utf16(i, word);
+            _add(icu::UnicodeString(false, word.data(), word.size()),
+                 snapshot.count(i));
+        }
+    }
+
+    // Retorna f(chave), com a chave da estrutura correspondente à palavra
+    template <typename function>
+    auto _with_key(const icu::UnicodeString& word, function f) {
+        if constexpr (_interned) {
+            interned_word key = _arena.intern(word);
+            rollback_guard guard{_arena, key};
+            return f(key);
+        } else {
+            return f(key_type(word));
+        }
+    }
 
    public:
     // Construtor
     dictionary() {}
 
-    // Insere uma palavra no dicionário
-    void insert(const icu::UnicodeString& word) {
-        try {
-            auto& value = _dict.search(word);
-            value += 1;
-        } catch (std::out_of_range& e) {
-            _dict.insert(word, 1);
-        }
-    }
-
-    // Insere um texto no dicionário (o texto já deve estar formatado, contendo
-    // apenas espaços e palavras)
-    void insert_text(icu::UnicodeString text) {
-        // Adiciona um espaço no final do texto para garantir que a última
-        // palavra será inserida
-        text += " ";
-
-        // Percorre o texto, separando as palavras e inserindo no dicionário
-        icu::UnicodeString word;
-        for (int i = 0; i < text.length(); i++) {
-            // Obtém o caractere na posição i
-            UChar32 c = text.char32At(i);
-            // Caso o caractere seja um espaço em branco, insere a palavra
-            // anterior ao espaço no dicionário
-            if (u_isUWhiteSpace(c)) {
-                if (!word.isEmpty()) {
-                    // Se a palavra não for vazia, insere no dicionário
-                    this->insert(word);
-                    // Limpa a palavra e prepara para a próxima
-                    word.remove();
-                }
-            } else {
-                // Não é um espaço em branco, adiciona o caractere à palavra
-                // atual
-                word += c;
-            }
+    // Insere uma palavra no dicionário (uma única busca na estrutura)
+    void insert(const icu::UnicodeString& word) { _add(word, 1); }
+
+    // Insere no dicionário as palavras de um texto bruto em UTF-8 (não
+    // formatado) que já está em memória, como um arquivo mapeado com mmap
+    void insert_utf8(const char* data, size_t size) {
+        utf8_tokenizer tokenizer;
+        auto emit = [this](const icu::UnicodeString& word) {
+            this->insert(word);
+        };
+
+        tokenizer.feed(data, size, emit);
+        tokenizer.finish(emit);
+    }
+
+    // Insere no dicionário as palavras de um texto bruto em UTF-8 (não
+    // formatado), lido em blocos do stream. O texto é normalizado e separado
+    // em palavras pelo utf8_tokenizer, sem manter o texto inteiro em memória
+    void insert_stream(std::istream& input) {
+        utf8_tokenizer tokenizer;
+        auto emit = [this](const icu::UnicodeString& word) {
+            this->insert(word);
+        };
+
+        std::vector<char> buffer(1 << 20);  // Blocos de 1 MiB
+        while (input) {
+            input.read(buffer.data(), buffer.size());
+            tokenizer.feed(buffer.data(), input.gcount(), emit);
         }
+        tokenizer.finish(emit);
+    }
+
+    // Soma ao dicionário as frequências das palavras de outro dicionário
+    void merge(const dictionary& other) {
+        other._dict.for_each([this](const auto& word, const auto& count) {
+            _add(word, count);
+        });
     }
 
     // Remove uma palavra do dicionário
-    void remove(const icu::UnicodeString& word) { _dict.remove(word); }
+    void remove(const icu::UnicodeString& word) {
+        _with_key(word, [this](const key_type& k) { _dict.remove(k); });
+    }
 
     // Limpa o dicionário
-    void clear() { _dict.clear(); }
+    void clear() {
+        _dict.clear();
+        _arena.clear();
+    }
 
     // Retorna a quantidade de palavras diferentes no dicionário
     unsigned int size() { return _dict.size(); }
@@ -74,14 +197,20 @@ class dictionary {
 
     // Verifica se uma palavra está no dicionário
     bool contains(const icu::UnicodeString& word) {
-        return _dict.contains(word);
+        return _with_key(
+            word, [this](const key_type& k) { return _dict.contains(k); });
     }
 
     // Atualiza a frequência de uma palavra
-    void att(const icu::UnicodeString& word, int att) { _dict.att(word, att); }
+    void att(const icu::UnicodeString& word, int att) {
+        _with_key(word, [&](const key_type& k) { _dict.att(k, att); });
+    }
 
     // Retorna a frequência de uma palavra
-    int search(const icu::UnicodeString& word) { return _dict.search(word); }
+    int search(const icu::UnicodeString& word) {
+        return _with_key(
+            word, [this](const key_type& k) { return _dict.search(k); });
+    }
 
     // Retorna uma lista das palavras do dicionário com suas frequências
     icu::UnicodeString list() {
@@ -101,26 +230,232 @@ class dictionary {
         std::cout << list_str;
     }
 
-    void save(const std::string& filename, std::chrono::milliseconds duration) {
+   private:
+    // Retorna o cabeçalho dos arquivos de saída, com o tamanho, os
+    // contadores, a memória e o tempo de cada etapa
+    std::string _header(std::chrono::milliseconds duration,
+                        const phase_timer& timer) {
         std::string list_str = "";
-        std::string comparisons = std::to_string(_dict.comparisons());
         list_str +=
             "Tamanho do dicionário: " + std::to_string(this->size()) + "\n";
+
+        // Os contadores só são impressos quando a contagem está habilitada
+        const auto& counters = _dict.counters();
+        if constexpr (std::decay_t<decltype(counters)>::enabled) {
+            list_str += "Número de comparações: " +
+                        std::to_string(counters.key_comparisons) + "\n";
+            list_str +=
+                "Número de sondagens: " + std::to_string(counters.probes) +
+                "\n";
+            list_str +=
+                "Número de rotações: " + std::to_string(counters.rotations) +
+                "\n";
+            list_str += "Elementos movidos em rehash: " +
+                        std::to_string(counters.rehash_moves) + "\n";
+        }
+
+        // Memória da estrutura (em save, medida depois da ordenação para
+        // incluir a cópia ordenada das chaves das tabelas hash)
+        memory_breakdown memory = this->memory_usage();
+        size_t words = std::max<size_t>(this->size(), 1);
+        list_str += "Memória da estrutura: " + std::to_string(memory.total()) +
+                    " bytes (" + std::to_string(memory.total() / words) +
+                    " bytes por palavra)\n";
+        list_str += "  nós: " + std::to_string(memory.nodes) + " bytes\n";
+        list_str += "  chaves na heap: " + std::to_string(memory.key_heap) +
+                    " bytes\n";
         list_str +=
-            "Número de comparações: " + std::to_string(_dict.comparisons()) +
-            "\n";
+            "  buckets: " + std::to_string(memory.buckets) + " bytes\n";
+        list_str += "  cópia ordenada das chaves: " +
+                    std::to_string(memory.sorted_keys) + " bytes\n";
+        list_str += "  folga do alocador: " + std::to_string(memory.slack) +
+                    " bytes\n";
         list_str +=
             "Tempo para montar a tabela: " + std::to_string(duration.count()) +
-            " milissegundos\n\n";
-        list_str += "Dicionário de palavras:\n\"Palavra\" - Frequência\n";
+            " milissegundos\n";
+        list_str += timer.report() + "\n";
+        return list_str;
+    }
+
+   public:
+    // Salva o dicionário no arquivo, com o cabeçalho de _header. A ordenação
+    // das chaves e a escrita do arquivo são medidas aqui e adicionadas ao
+    // timer; a escrita só aparece no timer, pois termina depois que o
+    // cabeçalho já foi escrito
+    void save(const std::string& filename, std::chrono::milliseconds duration,
+              phase_timer& timer) {
+        // Ordena as chaves (nas tabelas hash, begin() monta o vetor ordenado)
+        timer.measure("ordenação das chaves", [this] { _dict.begin(); });
+
+        std::string header = _header(duration, timer);
+        header += "Dicionário de palavras:\n\"Palavra\" - Frequência\n";
+
+        timer.measure("escrita do arquivo",
+                      [&] { _write_list(filename, header, _dict); });
+    }
+
+    // Salva no arquivo apenas as k palavras mais frequentes (top_k), com o
+    // mesmo cabeçalho de save. As chaves não são ordenadas pela collation
+    void save_top(const std::string& filename, size_t k,
+                  std::chrono::milliseconds duration, phase_timer& timer) {
+        std::vector<std::pair<icu::UnicodeString, int>> top;
+        timer.measure("seleção das mais frequentes", [&] { top = top_k(k); });
+
+        std::string header = _header(duration, timer);
+        header += "As " + std::to_string(top.size()) +
+                  " palavras mais frequentes:\n\"Palavra\" - Frequência\n";
+
+        timer.measure("escrita do arquivo",
+                      [&] { _write_list(filename, header, top); });
+    }
+
+    // Salva o dicionário em um snapshot binário (ver snapshot.hpp), com as
+    // palavras em ordem de colação
+    void save_snapshot(const std::string& filename) {
+        key_compare less;
+        if (!write_snapshot(filename, _dict, _dict.size(), *less.collator)) {
+            std::cerr << "Error: Could not write snapshot " << filename
+                      << std::endl;
+            exit(1);
+        }
+    }
+
+    // Substitui o conteúdo do dicionário pelo de um snapshot binário. O
+    // arquivo é mapeado e validado uma única vez; como as palavras já estão
+    // em ordem de colação, a estrutura é montada com assign_sorted (árvores
+    // balanceadas sem comparações, tabelas hash com um único rehash e a
+    // cópia ordenada das chaves já pronta). Um snapshot ordenado com outras
+    // regras de colação (outro locale ou outra versão da ICU) é inserido
+    // palavra a palavra
+    void load_snapshot(const std::string& filename) {
+        snapshot_view snapshot(filename);
+        _check_snapshot(snapshot, filename);
+
+        clear();
+        key_compare less;
+        if (!snapshot.same_collation(*less.collator)) {
+            _add_snapshot(snapshot);
+            return;
+        }
+
+        std::vector<std::pair<key_type, int>> entries;
+        entries.reserve(snapshot.size());
+        std::u16string word;
+        for (size_t i = 0; i < snapshot.size(); i++) {
+            snapshot.word_utf16(i, word);
+            entries.emplace_back(_make_key(word), snapshot.count(i));
+        }
+        _dict.assign_sorted(entries.begin(), entries.end());
+    }
+
+    // Soma ao dicionário as frequências de um snapshot binário com uma junção
+    // linear (merge-join) de duas sequências em ordem de colação: as palavras
+    // do dicionário (begin/end) e as do snapshot. Palavras equivalentes têm
+    // as frequências somadas e o resultado, já ordenado, remonta a estrutura
+    // com assign_sorted. Cada palavra do snapshot é comparada uma única vez
+    // com a palavra atual do dicionário, em vez de uma busca na estrutura.
+    // Como em load_snapshot, um snapshot ordenado com outras regras de
+    // colação é inserido palavra a palavra
+    void merge_snapshot(const std::string& filename) {
+        snapshot_view snapshot(filename);
+        _check_snapshot(snapshot, filename);
+
+        key_compare less;
+        if (!snapshot.same_collation(*less.collator)) {
+            _add_snapshot(snapshot);
+            return;
+        }
+
+        std::vector<std::pair<key_type, int>> entries;
+        entries.reserve(_dict.size() + snapshot.size());
+        auto it = _dict.begin();
+        auto end = _dict.end();
+        std::u16string word;
+        for (size_t i = 0; i < snapshot.size(); i++) {
+            snapshot.word_utf16(i, word);
+            key_type key = _make_key(word);
+
+            // Copia as palavras do dicionário que vêm antes da palavra
+            while (it != end && less(it->first, key)) {
+                entries.push_back(*it);
+                ++it;
+            }
+
+            if (it != end && !less(key, it->first)) {
+                // A palavra já está no dicionário: a chave nova é descartada
+                entries.emplace_back(it->first,
+                                     it->second + snapshot.count(i));
+                ++it;
+                if constexpr (_interned) {
+                    _arena.rollback(key);
+                }
+            } else {
+                entries.emplace_back(std::move(key), snapshot.count(i));
+            }
+        }
+        for (; it != end; ++it) {
+            entries.push_back(*it);
+        }
+        _dict.assign_sorted(entries.begin(), entries.end());
+    }
+
+    // Retorna as k palavras mais frequentes, da mais para a menos frequente
+    // (empates em ordem binária das palavras, sem collation). As entradas da
+    // estrutura são percorridas uma vez com for_each mantendo um min-heap das
+    // k melhores até o momento, com ponteiros para as chaves: O(n log k) e
+    // apenas k palavras copiadas, sem a cópia ordenada das tabelas hash
+    std::vector<std::pair<icu::UnicodeString, int>> top_k(size_t k) const {
+        using entry = std::pair<int, const key_type*>;
+
+        // Indica se a entrada a vem antes da entrada b no resultado. Com essa
+        // ordem, o topo do heap é a pior das k entradas guardadas
+        auto before = [](const entry& a, const entry& b) {
+            if (a.first != b.first) {
+                return a.first > b.first;
+            }
+            const icu::UnicodeString& word_a = *a.second;
+            const icu::UnicodeString& word_b = *b.second;
+            return word_a.compare(word_b) < 0;
+        };
+
+        std::vector<entry> heap;
+        heap.reserve(std::min<size_t>(k, _dict.size()));
+        if (k > 0) {
+            _dict.for_each([&](const key_type& key, const int& count) {
+                entry e(count, &key);
+                if (heap.size() < k) {
+                    heap.push_back(e);
+                    std::push_heap(heap.begin(), heap.end(), before);
+                } else if (before(e, heap.front())) {
+                    std::pop_heap(heap.begin(), heap.end(), before);
+                    heap.back() = e;
+                    std::push_heap(heap.begin(), heap.end(), before);
+                }
+            });
+        }
+        std::sort_heap(heap.begin(), heap.end(), before);
+
+        std::vector<std::pair<icu::UnicodeString, int>> top;
+        top.reserve(heap.size());
+        for (const entry& e : heap) {
+            top.emplace_back(icu::UnicodeString(*e.second), e.first);
+        }
+        return top;
+    }
+
+    // Retorna os contadores de operações da estrutura
+    const auto& counters() const { return _dict.counters(); }
 
-        // Convertendo UnicodeString para std::string
-        std::string list_content;
-        this->list().toUTF8String(list_content);
-        list_str += list_content;
+    // Retorna a memória usada pela estrutura, separada por categoria
+    memory_breakdown memory_usage() const {
+        memory_breakdown usage = _dict.memory_usage();
 
-        write_file(filename, list_str);
+        // As palavras internadas e as suas sort keys ficam na arena
+        usage.key_heap += _arena.used_bytes();
+        usage.slack += _arena.reserved_bytes() - _arena.used_bytes();
+        return usage;
     }
 
-    unsigned int comparisons() { return _dict.comparisons(); }
+    // Retorna as estatísticas de distribuição da estrutura (histogramas)
+    structure_stats stats() const { return _dict.stats(); }
 };
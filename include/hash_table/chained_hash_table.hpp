@@ -1,22 +1,42 @@
-#include <cmath>
+#include <algorithm>
 #include <functional>
 #include <iostream>
-#include <list>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "../counting.hpp"
+#include "../memory_usage.hpp"
+#include "../slab_allocator.hpp"
+#include "../statistics.hpp"
+#include "hash_utils.hpp"
+
 // Classe que implementa uma tabela hash com tratamento de colisão por
-// encadeamento exterior
+// encadeamento exterior. Cada slot é uma lista simplesmente encadeada de nós
+// alocados em um pool (slab_pool), e o rehash apenas religa os nós. A
+// política counting define se as operações são contadas
 template <typename key_t, typename value_t, typename hash = std::hash<key_t>,
-          typename compare = std::less<key_t>>
+          typename compare = std::less<key_t>,
+          typename counting = default_counting_policy>
 class chained_hash_table {
    private:
+    // Nó de um slot: par (chave, valor) e o hash completo da chave, que
+    // evita recalcular o hash no rehash e comparar chaves com hashes diferentes
+    struct node {
+        key_t key;          // Chave
+        value_t value;      // Valor associado à chave
+        size_t hash_value;  // Hash da chave
+        node* next;         // Próximo nó do slot
+    };
+
     size_t _number_of_elements;  // Número de elementos na tabela hash
-    size_t _table_size;          // Tamanho atual da tabela hash
+    size_t _table_size;          // Tamanho atual da tabela (potência de 2)
+    int _shift;                  // Deslocamento do hashing de Fibonacci
 
-    // Vetor de listas de pares (chave, valor)
-    std::vector<std::list<std::pair<key_t, value_t>>>* _table;
+    // Vetor com o primeiro nó de cada slot
+    std::vector<node*>* _table;
+
+    slab_pool<node> _pool;  // Pool de onde os nós são alocados
 
     float _load_factor;      // Fator de carga atual da tabela hash
     float _max_load_factor;  // Fator de carga máximo permitido
@@ -29,46 +49,79 @@ class chained_hash_table {
     // Flag para indicar se o vetor de chaves ordenadas está desatualizado
     bool _keys_dirty;
 
-    unsigned int _comparisons;  // Número de comparações realizadas
+    mutable counting _counters;  // Contadores de operações
 
-    // Encontra o próximo número primo maior ou igual a x
-    size_t get_next_prime(size_t x) {
-        // Se x for par, incrementa para o próximo ímpar
-        _comparisons++;
-        if (x % 2 == 0) {
-            x++;
-        }
+    // Compara duas chaves por igualdade, contando a comparação
+    bool _equal(const key_t& a, const key_t& b) const {
+        _counters.comparison();
+        return a == b;
+    }
 
-        // Itera para encontrar o próximo número primo
-        _comparisons++;
-        while (true) {
-            // Verifica se x é divisível por algum número ímpar até a raiz
-            bool is_prime = true;
-            _comparisons++;
-            for (size_t i = 3; i <= std::sqrt(x); i += 2) {
-                // Se x for divisível por i, não é um número primo
-                _comparisons++;
-                if (x % i == 0) {
-                    is_prime = false;
-                    break;
-                }
-                _comparisons++;
-            }
-            _comparisons++;
+    // Calcula o índice da tabela hash para uma chave cujo hash é h
+    size_t hash_code(size_t h) const { return fibonacci_index(h, _shift); }
+
+    // Percorre o slot i procurando a chave k (com hash h). Retorna o ponteiro
+    // para o elo que aponta para o nó da chave, ou para o elo nulo no final do
+    // slot caso a chave não exista (onde um novo nó deve ser ligado)
+    node** find_link(const key_t& k, size_t h, size_t i) {
+        node** link = &(*_table)[i];
 
-            // Se encontrou um número primo, retorna x
-            _comparisons++;
-            if (is_prime) {
-                return x;
+        while (*link != nullptr) {
+            _counters.probe();
+            if ((*link)->hash_value == h && _equal((*link)->key, k)) {
+                return link;
             }
+            link = &(*link)->next;
+        }
+
+        return link;
+    }
 
-            // Senão, vai para o próximo número ímpar
-            x += 2;
+    // Versão constante de find_link, que retorna o nó da chave ou nullptr
+    const node* find_node(const key_t& k, size_t h, size_t i) const {
+        for (const node* n = (*_table)[i]; n != nullptr; n = n->next) {
+            _counters.probe();
+            if (n->hash_value == h && _equal(n->key, k)) {
+                return n;
+            }
         }
+        return nullptr;
+    }
+
+    // Cria um nó para o par (k, v) e o liga no elo dado. A chave e o valor
+    // são copiados ou movidos para o nó, conforme os argumentos
+    template <typename key_arg, typename value_arg>
+    node* link_node(node** link, key_arg&& k, value_arg&& v, size_t h) {
+        *link = _pool.create(node{std::forward<key_arg>(k),
+                                  std::forward<value_arg>(v), h, nullptr});
+        _number_of_elements++;  // Incrementa o número de elementos
+        _keys_dirty = true;     // Marca as chaves como desatualizadas
+        return *link;
     }
 
-    // Calcula o índice da tabela hash para uma chave k
-    size_t hash_code(const key_t& k) const { return _hashing(k) % _table_size; }
+    // Retorna o nó da chave k, inserindo-a com o valor v no final do slot
+    // caso ela não exista (uma única busca no slot)
+    template <typename key_arg, typename value_arg>
+    node* _find_or_insert(key_arg&& k, value_arg&& v, bool& inserted) {
+        // Verifica se o fator de carga excedeu o máximo
+        if (load_factor() > _max_load_factor) {
+            rehash(2 * _table_size);
+        }
+
+        // Calcula o índice da tabela hash para a chave k
+        size_t h = _hashing(k);
+        size_t i = hash_code(h);
+
+        // Procura a chave k na lista do slot correspondente
+        node** link = find_link(k, h, i);
+        inserted = *link == nullptr;
+        if (!inserted) {
+            return *link;
+        }
+
+        return link_node(link, std::forward<key_arg>(k),
+                         std::forward<value_arg>(v), h);
+    }
 
     // Atualiza o vetor de chaves ordenadas
     void update_sorted_keys() {
@@ -79,8 +132,8 @@ class chained_hash_table {
         // Itera sobre cada bucket da tabela hash
         for (size_t i = 0; i < _table_size; i++) {
             // Adiciona cada par (chave, valor) ao vetor de chaves ordenadas
-            for (const auto& p : (*_table)[i]) {
-                _sorted_keys.push_back(p);
+            for (const node* n = (*_table)[i]; n != nullptr; n = n->next) {
+                _sorted_keys.emplace_back(n->key, n->value);
             }
         }
 
@@ -95,13 +148,18 @@ class chained_hash_table {
     }
 
    public:
+    using key_type = key_t;       // Tipo das chaves
+    using mapped_type = value_t;  // Tipo dos valores
+    using key_compare = compare;  // Ordem das chaves
+
     // Construtor da tabela hash
     chained_hash_table(size_t table_size = 19, const hash& hf = hash())
         : _number_of_elements(0),
-          _table_size(get_next_prime(table_size)),
-          _comparisons(0),
-          _table(new std::vector<std::list<std::pair<key_t, value_t>>>(
-              _table_size)),
+          _table_size(next_power_of_two(table_size)),
+          _shift(fibonacci_shift(_table_size)),
+          _counters(),
+          _table(new std::vector<node*>(_table_size, nullptr)),
+          _pool(),
           _load_factor(0),
           _max_load_factor(0.75),
           _hashing(hf),
@@ -119,10 +177,16 @@ class chained_hash_table {
     size_t bucket_count() const { return _table_size; }
 
     // Retorna o número de elementos em um slot (bucket) específico
-    size_t bucket_size(size_t n) const { return (*_table)[n].size(); }
+    size_t bucket_size(size_t n) const {
+        size_t count = 0;
+        for (const node* p = (*_table)[n]; p != nullptr; p = p->next) {
+            count++;
+        }
+        return count;
+    }
 
     // Retorna o índice do slot (bucket) de uma chave k
-    size_t bucket(const key_t& k) const { return hash_code(k); }
+    size_t bucket(const key_t& k) const { return hash_code(_hashing(k)); }
 
     // Retorna o fator de carga atual
     float load_factor() const {
@@ -135,7 +199,6 @@ class chained_hash_table {
     // Define o fator de carga atual e faz rehashing se necessário
     void load_factor(float lf) {
         // Verifica se o fator de carga está fora do intervalo
-        _comparisons++;
         if (lf <= 0 || lf > _max_load_factor) {
             throw std::out_of_range("load factor out of range");
         }
@@ -143,7 +206,6 @@ class chained_hash_table {
         _load_factor = lf;  // Atualiza o fator de carga
 
         // Redimensiona a tabela se o fator de carga exceder o máximo
-        _comparisons++;
         if (load_factor() > _load_factor) {
             rehash(2 * _table_size);
         }
@@ -152,7 +214,6 @@ class chained_hash_table {
     // Define o fator de carga máximo
     void max_load_factor(float lf) {
         // Verifica se o fator de carga máximo está fora do intervalo
-        _comparisons++;
         if (lf <= 0 || lf < _load_factor) {
             throw std::out_of_range("max load factor out of range");
         }
@@ -162,94 +223,133 @@ class chained_hash_table {
     // Redimensiona a tabela hash para um novo tamanho
     void rehash(size_t new_size) {
         // Se o novo tamanho for menor ou igual ao atual, não faz nada
-        _comparisons++;
         if (new_size <= _table_size) {
             return;
         }
 
-        // Encontra o próximo número primo maior ou igual ao novo tamanho
-        new_size = get_next_prime(new_size);
-
-        // Cria uma nova tabela hash com o novo tamanho
-        auto new_table =
-            new std::vector<std::list<std::pair<key_t, value_t>>>(new_size);
-
-        // Transfere os elementos da tabela antiga para a nova tabela
-        _comparisons++;
-        for (const auto& bucket : *_table) {
-            _comparisons++;
-            for (const auto& p : bucket) {
-                size_t index = _hashing(p.first) % new_size;
-                (*new_table)[index].push_back(p);
-                _comparisons++;
+        // Encontra a próxima potência de 2 maior ou igual ao novo tamanho
+        new_size = next_power_of_two(new_size);
+        int new_shift = fibonacci_shift(new_size);
+
+        // Cria uma nova tabela hash com o novo tamanho e guarda o último elo
+        // de cada slot, para manter a ordem relativa dos nós
+        auto new_table = new std::vector<node*>(new_size, nullptr);
+        std::vector<node**> tails(new_size);
+        for (size_t i = 0; i < new_size; i++) {
+            tails[i] = &(*new_table)[i];
+        }
+
+        // Religa os nós da tabela antiga na nova tabela, sem copiar as chaves
+        for (node* bucket : *_table) {
+            while (bucket != nullptr) {
+                _counters.rehash_move();
+                node* n = bucket;
+                bucket = n->next;
+
+                // Usa o hash guardado no nó, sem recalcular o hash
+                size_t index = fibonacci_index(n->hash_value, new_shift);
+                n->next = nullptr;
+                *tails[index] = n;
+                tails[index] = &n->next;
             }
-            _comparisons++;
         }
-        _comparisons++;
 
         delete _table;           // Libera a memória da tabela antiga
         _table = new_table;      // Atualiza o ponteiro para a nova tabela
         _table_size = new_size;  // Atualiza o tamanho da tabela
+        _shift = new_shift;      // Atualiza o deslocamento do hashing
         _keys_dirty = true;      // Marca as chaves como desatualizadas
     }
 
-    // Insere a chave k na tabela hash associada ao valor v
-    bool insert(const key_t k, const value_t v) {
-        // Verifica se o fator de carga excedeu o máximo
-        _comparisons++;
-        if (load_factor() > _max_load_factor) {
-            rehash(2 * _table_size);
+    // Substitui o conteúdo da tabela pelos pares [first, last), que devem
+    // estar em ordem estritamente crescente de chave. A tabela é
+    // redimensionada uma única vez e os pares já ordenados viram a cópia
+    // ordenada das chaves, então a próxima iteração não precisa ordenar
+    template <typename iterator_t>
+    void assign_sorted(iterator_t first, iterator_t last) {
+        clear();
+        size_t n = last - first;
+        rehash(static_cast<size_t>(n / _max_load_factor) + 1);
+        for (iterator_t it = first; it != last; ++it) {
+            insert(it->first, it->second);
         }
+        _sorted_keys.assign(first, last);
+        _keys_dirty = false;
+    }
 
-        // Calcula o índice da tabela hash para a chave k
-        size_t i = hash_code(k);
-
-        // Itera para encontrar a chave k na lista do slot correspondente
-        _comparisons++;
-        for (auto& p : (*_table)[i]) {
-            _comparisons++;
-            if (p.first == k) {
-                return false;  // Chave já existe, não insere
-            }
-            _comparisons++;
-        }
-        _comparisons++;
+    // Insere a chave k na tabela hash associada ao valor v
+    bool insert(const key_t& k, const value_t& v) {
+        bool inserted;
+        _find_or_insert(k, v, inserted);
+        return inserted;
+    }
 
-        // Insere a chave k e o valor v na lista do slot correspondente
-        (*_table)[i].push_back(std::make_pair(k, v));
-        _number_of_elements++;  // Incrementa o número de elementos
-        _keys_dirty = true;     // Marca as chaves como desatualizadas
-        return true;            // Chave inserida com sucesso
+    // Insere a chave k na tabela hash, movendo-a para o novo nó
+    bool insert(key_t&& k, const value_t& v) {
+        bool inserted;
+        _find_or_insert(std::move(k), v, inserted);
+        return inserted;
+    }
+
+    // Constrói o par (chave, valor) a partir de args e o insere na tabela
+    // hash, movendo a chave e o valor para o novo nó
+    template <typename... args_t>
+    bool emplace(args_t&&... args) {
+        std::pair<key_t, value_t> p(std::forward<args_t>(args)...);
+        bool inserted;
+        _find_or_insert(std::move(p.first), std::move(p.second), inserted);
+        return inserted;
+    }
+
+    // Retorna a referência para o valor associado à chave k, inserindo a chave
+    // com o valor v caso ela não exista (uma única busca no slot)
+    value_t& find_or_insert(const key_t& k, const value_t& v) {
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
+        bool inserted;
+        return _find_or_insert(k, v, inserted)->value;
+    }
+
+    // Igual a find_or_insert, mas move a chave para o novo nó (se criado)
+    value_t& find_or_insert(key_t&& k, const value_t& v) {
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
+        bool inserted;
+        return _find_or_insert(std::move(k), v, inserted)->value;
     }
 
     // Remove a chave k da tabela hash
     bool remove(const key_t& k) {
         // Calcula o índice da tabela hash para a chave k
-        size_t i = hash_code(k);
-
-        // Itera para encontrar a chave k na lista do slot correspondente
-        _comparisons++;
-        for (auto it = (*_table)[i].begin(); it != (*_table)[i].end(); ++it) {
-            _comparisons++;
-            if (it->first == k) {
-                (*_table)[i].erase(it);  // Remove a chave da lista
-                _number_of_elements--;   // Decrementa o número de elementos
-                _keys_dirty = true;      // Marca as chaves como desatualizadas
-                return true;             // Chave removida com sucesso
-            }
-            _comparisons++;
+        size_t h = _hashing(k);
+        size_t i = hash_code(h);
+
+        // Procura a chave k na lista do slot correspondente
+        node** link = find_link(k, h, i);
+        if (*link == nullptr) {
+            return false;  // Chave não encontrada, não remove
         }
-        _comparisons++;
 
-        return false;  // Chave não encontrada, não remove
+        // Desliga o nó da lista e devolve sua memória ao pool
+        node* n = *link;
+        *link = n->next;
+        _pool.destroy(n);
+        _number_of_elements--;  // Decrementa o número de elementos
+        _keys_dirty = true;     // Marca as chaves como desatualizadas
+        return true;            // Chave removida com sucesso
     }
 
     // Limpa todos os elementos da tabela hash
     void clear() {
-        // Limpa cada bucket da tabela hash
+        // Destrói os nós de cada bucket da tabela hash
         for (size_t i = 0; i < _table_size; i++) {
-            (*_table)[i].clear();
+            node* n = (*_table)[i];
+            while (n != nullptr) {
+                node* next = n->next;
+                n->~node();
+                n = next;
+            }
+            (*_table)[i] = nullptr;
         }
+        _pool.release();  // Libera todos os blocos do pool de uma vez
 
         // Reseta o número de elementos e a flag de chaves desatualizadas
         _number_of_elements = 0;
@@ -264,55 +364,57 @@ class chained_hash_table {
 
     // Retorna a referência para o valor associado à chave k
     value_t& search(const key_t& k) {
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
         // Calcula o índice da tabela hash para a chave k
-        size_t i = hash_code(k);
-
-        // Itera para encontrar a chave k na lista do slot correspondente
-        _comparisons++;
-        for (auto& p : (*_table)[i]) {
-            _comparisons++;
-            if (p.first == k) {
-                return p.second;
-            }
-            _comparisons++;
+        size_t h = _hashing(k);
+        size_t i = hash_code(h);
+
+        // Procura a chave k na lista do slot correspondente
+        node** link = find_link(k, h, i);
+        if (*link != nullptr) {
+            return (*link)->value;
         }
-        _comparisons++;
 
         // Se a chave não foi encontrada, lança uma exceção
         throw std::out_of_range("Key not found");
     }
 
+    // Retorna um ponteiro para o valor associado à chave k, ou nullptr caso a
+    // chave não exista
+    value_t* find(const key_t& k) {
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
+        // Calcula o índice da tabela hash para a chave k
+        size_t h = _hashing(k);
+        size_t i = hash_code(h);
+
+        // Procura a chave k na lista do slot correspondente
+        node** link = find_link(k, h, i);
+        return *link != nullptr ? &(*link)->value : nullptr;
+    }
+
     // Verifica se a chave k está na tabela hash
     bool contains(const key_t& k) const {
         // Calcula o índice da tabela hash para a chave k
-        size_t i = hash_code(k);
+        size_t h = _hashing(k);
+        size_t i = hash_code(h);
 
-        // Itera para encontrar a chave k na lista do slot correspondente
-        for (const auto& p : (*_table)[i]) {
-            if (p.first == k) {
-                return true;  // Chave encontrada
-            }
-        }
-        return false;  // Chave não encontrada
+        // Procura a chave k na lista do slot correspondente
+        return find_node(k, h, i) != nullptr;
     }
 
     // Atualiza o valor associado à chave k
     void att(const key_t& k, value_t v) {
         // Calcula o índice da tabela hash para a chave k
-        size_t i = hash_code(k);
-
-        // Itera para encontrar a chave k na lista do slot correspondente
-        _comparisons++;
-        for (auto it = (*_table)[i].begin(); it != (*_table)[i].end(); ++it) {
-            _comparisons++;
-            if (it->first == k) {
-                it->second = v;      // Atualiza o valor associado à chave k
-                _keys_dirty = true;  // Marca as chaves como desatualizadas
-                return;
-            }
-            _comparisons++;
+        size_t h = _hashing(k);
+        size_t i = hash_code(h);
+
+        // Procura a chave k na lista do slot correspondente
+        node** link = find_link(k, h, i);
+        if (*link != nullptr) {
+            (*link)->value = v;  // Atualiza o valor associado à chave k
+            _keys_dirty = true;  // Marca as chaves como desatualizadas
+            return;
         }
-        _comparisons++;
 
         // Se a chave não foi encontrada, lança uma exceção
         throw std::out_of_range("Key not found");
@@ -321,43 +423,39 @@ class chained_hash_table {
     // Sobrecarga do operador de indexação para acessar ou modificar o valor
     // associado à chave k
     value_t& operator[](const key_t& k) {
-        // Calcula o índice da tabela hash para a chave k
-        size_t i = hash_code(k);
-
-        // Itera para encontrar a chave k na lista do slot correspondente
-        _comparisons++;
-        for (auto& p : (*_table)[i]) {
-            _comparisons++;
-            if (p.first == k) {
-                return p.second;
-            }
-            _comparisons++;
-        }
-        _comparisons++;
-
-        (*_table)[i].push_back(std::make_pair(k, value_t()));
-        _number_of_elements++;  // Incrementa o número de elementos
-        _keys_dirty = true;     // Marca as chaves como desatualizadas
-        return (*_table)[i].back().second;
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
+        bool inserted;
+        return _find_or_insert(k, value_t(), inserted)->value;
     }
 
     // Sobrecarga do operador de indexação constante para acessar o valor
     // associado à chave k
     const value_t& operator[](const key_t& k) const {
         // Calcula o índice da tabela hash para a chave k
-        size_t i = hash_code(k);
+        size_t h = _hashing(k);
+        size_t i = hash_code(h);
 
-        // Itera para encontrar a chave k na lista do slot correspondente
-        for (const auto& p : (*_table)[i]) {
-            if (p.first == k) {
-                return p.second;
-            }
+        // Procura a chave k na lista do slot correspondente
+        const node* n = find_node(k, h, i);
+        if (n != nullptr) {
+            return n->value;
         }
 
         // Se a chave não foi encontrada, lança uma exceção
         throw std::out_of_range("Key not found");
     }
 
+    // Percorre todos os pares da tabela na ordem em que estão armazenados
+    // (sem ordenar as chaves), chamando f(chave, valor)
+    template <typename function>
+    void for_each(function f) const {
+        for (const node* bucket : *_table) {
+            for (const node* n = bucket; n != nullptr; n = n->next) {
+                f(n->key, n->value);
+            }
+        }
+    }
+
     // Classe de iterador para percorrer as chaves da tabela hash
     // O Iterador não acessa diretamente a tabela hash, mas sim um vetor de
     // chaves ordenadas
@@ -416,6 +514,32 @@ class chained_hash_table {
         return iterator(this, _sorted_keys.size());
     }
 
-    // Retorna o número de comparações feitas
-    unsigned int comparisons() const { return _comparisons; }
+    // Retorna os contadores de operações
+    const counting& counters() const { return _counters; }
+
+    // Retorna a memória usada pela tabela, separada por categoria
+    memory_breakdown memory_usage() const {
+        memory_breakdown usage;
+        usage.nodes = _number_of_elements * sizeof(node);
+        for_each([&usage](const key_t& k, const value_t& v) {
+            usage.key_heap += heap_bytes(k) + heap_bytes(v);
+        });
+        usage.buckets =
+            sizeof(*_table) + _table->capacity() * sizeof(node*);
+        usage.sorted_keys = sorted_keys_bytes(_sorted_keys);
+        usage.slack = _pool.reserved_bytes() - usage.nodes;
+        return usage;
+    }
+
+    // Retorna as estatísticas de distribuição da tabela: o histograma do
+    // número de elementos em cada bucket
+    structure_stats stats() const {
+        structure_stats s;
+        histogram lengths;
+        for (size_t i = 0; i < _table_size; i++) {
+            lengths.add(bucket_size(i));
+        }
+        s.histograms.push_back({"tamanho dos buckets", lengths});
+        return s;
+    }
 };
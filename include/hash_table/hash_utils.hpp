@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Funções auxiliares para tabelas hash com tamanho potência de 2. O índice de
+// uma chave é obtido por hashing multiplicativo de Fibonacci: o hash é
+// multiplicado por 2^64 / φ e os bits mais altos do produto formam o índice.
+// Assim nenhuma divisão (%) é feita ao calcular os índices.
+
+// Retorna a menor potência de 2 maior ou igual a x (no mínimo 2)
+inline size_t next_power_of_two(size_t x) {
+    size_t size = 2;
+    while (size < x) {
+        size *= 2;
+    }
+    return size;
+}
+
+// Retorna o deslocamento usado por fibonacci_index para uma tabela de size
+// posições (size deve ser potência de 2)
+inline int fibonacci_shift(size_t size) {
+    int shift = 64;
+    while (size > 1) {
+        size /= 2;
+        shift--;
+    }
+    return shift;
+}
+
+// Espalha os bits do hash h e retorna um índice em [0, 2^(64 - shift))
+inline size_t fibonacci_index(size_t h, int shift) {
+    return static_cast<size_t>(
+        (static_cast<uint64_t>(h) * 0x9E3779B97F4A7C15ull) >> shift);
+}
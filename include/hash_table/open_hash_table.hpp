@@ -1,14 +1,34 @@
 #include <algorithm>
-#include <cmath>
 #include <functional>
 #include <iostream>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "../counting.hpp"
+#include "../memory_usage.hpp"
+#include "../statistics.hpp"
+#include "hash_utils.hpp"
+
+// Políticas de sondagem da open_hash_table
+
+// Hashing duplo; a remoção marca a entrada como removida (DELETED)
+struct double_hashing {};
+
+// Sondagem linear Robin Hood: na inserção, uma chave mais distante da sua
+// posição ideal toma o lugar de uma chave mais próxima da sua, o que limita a
+// variação do tamanho das sondagens. A remoção desloca as entradas seguintes
+// uma posição para trás, sem deixar entradas removidas
+struct robin_hood_hashing {};
+
 // Classe que implementa uma tabela hash com tratamento de colisão por
-// endereçamento aberto (hashing duplo)
+// endereçamento aberto (hashing duplo ou Robin Hood, conforme a política). A
+// política counting define se as operações são contadas
 template <typename key_t, typename value_t, typename hash = std::hash<key_t>,
-          typename compare = std::less<key_t>>
+          typename compare = std::less<key_t>,
+          typename probing = double_hashing,
+          typename counting = default_counting_policy>
 class open_hash_table {
    private:
     // Enumeração para os estados de uma entrada na tabela hash
@@ -19,10 +39,17 @@ class open_hash_table {
         key_t key{};               // Chave da entrada
         value_t value{};           // Valor associado à chave
         entry_state state{EMPTY};  // Estado da entrada
+        size_t hash_value{0};      // Hash da chave (evita recalcular o hash)
+        unsigned int distance{0};  // Distância até a posição ideal (Robin Hood)
     };
 
+    // Indica se a tabela usa a política Robin Hood
+    static constexpr bool _robin_hood =
+        std::is_same<probing, robin_hood_hashing>::value;
+
     size_t _number_of_elements;  // Número de elementos na tabela hash
-    size_t _table_size;          // Tamanho atual da tabela hash
+    size_t _table_size;          // Tamanho atual da tabela (potência de 2)
+    int _shift;                  // Deslocamento do hashing de Fibonacci
     std::vector<entry> _table;   // Vetor de entradas da tabela hash
     float _load_factor;          // Fator de carga atual da tabela hash
     float _max_load_factor;      // Fator de carga máximo permitido
@@ -35,49 +62,171 @@ class open_hash_table {
     // Flag para indicar se o vetor de chaves ordenadas está desatualizado
     bool _keys_dirty;
 
-    unsigned int _comparisons;  // Número de comparações realizadas
+    mutable counting _counters;  // Contadores de operações
+
+    // Compara duas chaves por igualdade, contando a comparação
+    bool _equal(const key_t &a, const key_t &b) const {
+        _counters.comparison();
+        return a == b;
+    }
 
-    // Encontra o próximo número primo maior ou igual a x
-    size_t get_next_prime(size_t x) {
-        // Se x for par, incrementa para o próximo ímpar
-        _comparisons++;
-        if (x % 2 == 0) {
-            x++;
+    // Calcula o índice da tabela hash na i-ésima sondagem de uma chave cujo
+    // hash é h (hashing duplo). Como o tamanho da tabela é potência de 2, o
+    // passo é ímpar para que a sondagem passe por todas as posições
+    size_t hash_code(const size_t h, const size_t i = 0) const {
+        size_t hash1 = fibonacci_index(h, _shift);
+        size_t hash2 = (h << 1) | 1;
+        return (hash1 + i * hash2) & (_table_size - 1);
+    }
+
+    // Calcula a posição ideal de uma chave cujo hash é h (Robin Hood)
+    size_t home(const size_t h) const { return fibonacci_index(h, _shift); }
+
+    // Procura a chave k com a política Robin Hood, retornando a sua posição ou
+    // _table_size caso a chave não exista. A busca termina ao encontrar uma
+    // entrada vazia ou uma entrada mais próxima da sua posição ideal do que a
+    // chave procurada estaria
+    size_t rh_find_index(const key_t &k) const {
+        size_t h = _hash(k);
+        size_t index = home(h);
+        for (unsigned int d = 0;; d++) {
+            _counters.probe();
+            const entry &e = _table[index];
+            if (e.state != OCCUPIED || e.distance < d) {
+                return _table_size;
+            }
+            if (e.hash_value == h && _equal(e.key, k)) {
+                return index;
+            }
+            index = (index + 1) & (_table_size - 1);
         }
+    }
 
-        // Itera para encontrar o próximo número primo
-        _comparisons++;
+    // Coloca a entrada e (que ainda não está na tabela) a partir da posição
+    // index, trocando-a com as entradas mais próximas das suas posições ideais
+    // (Robin Hood). Retorna a posição final da entrada e
+    size_t rh_place(entry &&e, size_t index) {
+        size_t result = _table_size;
         while (true) {
-            // Verifica se x é divisível por algum número ímpar até a raiz
-            bool is_prime = true;
-            _comparisons++;
-            for (size_t i = 3; i <= std::sqrt(x); i += 2) {
-                // Se x for divisível por i, não é um número primo
-                _comparisons++;
-                if (x % i == 0) {
-                    is_prime = false;
-                    break;
+            _counters.probe();
+            entry &current = _table[index];
+            if (current.state != OCCUPIED) {
+                current = std::move(e);
+                return result == _table_size ? index : result;
+            }
+
+            // A entrada carregada está mais longe da posição ideal e toma o
+            // lugar da entrada atual
+            if (current.distance < e.distance) {
+                std::swap(current, e);
+                if (result == _table_size) {
+                    result = index;
                 }
-                _comparisons++;
             }
-            _comparisons++;
+            index = (index + 1) & (_table_size - 1);
+            e.distance++;
+        }
+    }
 
-            // Se encontrou um número primo, retorna x
-            _comparisons++;
-            if (is_prime) {
-                return x;
+    // Retorna a referência para o valor da chave k, inserindo-a com o valor v
+    // caso não exista (Robin Hood)
+    template <typename key_arg, typename value_arg>
+    value_t &rh_find_or_insert(key_arg &&k, value_arg &&v, bool &inserted) {
+        // Sonda até encontrar a chave k ou a posição onde ela seria inserida
+        size_t h = _hash(k);
+        size_t index = home(h);
+        unsigned int d = 0;
+        while (true) {
+            _counters.probe();
+            entry &e = _table[index];
+            if (e.state != OCCUPIED || e.distance < d) {
+                break;
+            }
+            if (e.hash_value == h && _equal(e.key, k)) {
+                inserted = false;
+                return e.value;  // Chave encontrada
             }
+            index = (index + 1) & (_table_size - 1);
+            d++;
+        }
+
+        // A chave não existe, insere a partir da posição encontrada
+        size_t position = rh_place(
+            entry{std::forward<key_arg>(k), std::forward<value_arg>(v),
+                  OCCUPIED, h, d},
+            index);
+        _number_of_elements++;
+        _keys_dirty = true;
+        inserted = true;
+        return _table[position].value;
+    }
 
-            // Senão, vai para o próximo número ímpar
-            x += 2;
+    // Retorna a referência para o valor da chave k, inserindo-a com o valor v
+    // caso não exista. A chave e o valor são copiados ou movidos (conforme os
+    // argumentos) apenas para a entrada onde a chave é inserida
+    template <typename key_arg, typename value_arg>
+    value_t &_find_or_insert(key_arg &&k, value_arg &&v, bool &inserted) {
+        // Verifica se o fator de carga excedeu o máximo
+        if (load_factor() > _max_load_factor) {
+            rehash(2 * _table_size);
         }
+
+        if constexpr (_robin_hood) {
+            return rh_find_or_insert(std::forward<key_arg>(k),
+                                     std::forward<value_arg>(v), inserted);
+        }
+
+        // Sonda até encontrar a chave k ou um slot vazio, lembrando o primeiro
+        // slot removido para reaproveitá-lo na inserção
+        size_t h = _hash(k);  // Hash da chave, calculado uma única vez
+        size_t i = 0;
+        size_t index;
+        size_t free_index = _table_size;
+        do {
+            _counters.probe();
+            index = hash_code(h, i++);  // Calcula o índice da tabela hash
+            if (_table[index].state == EMPTY) {
+                break;
+            } else if (_table[index].state == DELETED) {
+                if (free_index == _table_size) {
+                    free_index = index;
+                }
+            } else if (_table[index].hash_value == h &&
+                       _equal(_table[index].key, k)) {
+                inserted = false;
+                return _table[index].value;  // Chave encontrada
+            }
+
+        } while (i < _table_size);
+
+        // A chave não existe, insere no primeiro slot livre encontrado
+        if (free_index == _table_size) {
+            free_index = index;
+        }
+        _table[free_index].key = std::forward<key_arg>(k);
+        _table[free_index].value = std::forward<value_arg>(v);
+        _table[free_index].hash_value = h;
+        _table[free_index].state = OCCUPIED;
+        _number_of_elements++;
+        _keys_dirty = true;
+        inserted = true;
+        return _table[free_index].value;
     }
 
-    // Calcula o índice da tabela hash para uma chave k (hashing duplo)
-    size_t hash_code(const key_t &k, const size_t i = 0) const {
-        size_t hash1 = _hash(k);
-        size_t hash2 = 1 + (hash1 % (_table_size - 1));
-        return (hash1 + i * hash2) % _table_size;
+    // Remove a entrada na posição index deslocando para trás as entradas
+    // seguintes que não estão na sua posição ideal (Robin Hood)
+    void rh_remove_at(size_t index) {
+        size_t next = (index + 1) & (_table_size - 1);
+        while (_table[next].state == OCCUPIED && _table[next].distance > 0) {
+            _counters.probe();
+            _table[index] = std::move(_table[next]);
+            _table[index].distance--;
+            index = next;
+            next = (next + 1) & (_table_size - 1);
+        }
+        _table[index] = entry();  // A última posição fica vazia
+        _number_of_elements--;
+        _keys_dirty = true;
     }
 
     // Atualiza o vetor de chaves ordenadas
@@ -105,10 +254,15 @@ class open_hash_table {
     }
 
    public:
+    using key_type = key_t;       // Tipo das chaves
+    using mapped_type = value_t;  // Tipo dos valores
+    using key_compare = compare;  // Ordem das chaves
+
     // Construtor padrão da tabela hash
     open_hash_table(size_t table_size = 19, const hash &hf = hash())
         : _number_of_elements(0),
-          _table_size(get_next_prime(table_size)),
+          _table_size(next_power_of_two(table_size)),
+          _shift(fibonacci_shift(_table_size)),
           _table(_table_size),
           _load_factor(0),
           _max_load_factor(0.75),
@@ -116,7 +270,7 @@ class open_hash_table {
           _compare(compare()),
           _sorted_keys(),
           _keys_dirty(true),
-          _comparisons(0) {}
+          _counters() {}
 
     // Destrutor da tabela hash
     ~open_hash_table() { clear(); }
@@ -135,7 +289,6 @@ class open_hash_table {
     // Define o fator de carga da tabela hash
     void load_factor(float lf) {
         // Verifica se o fator de carga está fora do intervalo permitido
-        _comparisons++;
         if (lf <= 0 || lf > _max_load_factor) {
             throw std::out_of_range("load factor out of range");
         }
@@ -143,7 +296,6 @@ class open_hash_table {
         _load_factor = lf;  // Atualiza o fator de carga
 
         // Redimensiona a tabela se o fator de carga exceder o máximo
-        _comparisons++;
         if (load_factor() > _load_factor) {
             rehash(2 * _table_size);
         }
@@ -152,7 +304,6 @@ class open_hash_table {
     // Define o fator de carga máximo permitido
     void max_load_factor(float lf) {
         // Verifica se o fator de carga máximo está fora do intervalo permitido
-        _comparisons++;
         if (lf <= 0 || lf < _load_factor) {
             throw std::out_of_range("max load factor out of range");
         }
@@ -162,100 +313,147 @@ class open_hash_table {
     // Redimensiona a tabela hash para um novo tamanho
     void rehash(size_t new_size) {
         // Se o novo tamanho for menor ou igual ao atual, não faz nada
-        _comparisons++;
         if (new_size <= _table_size) {
             return;
         }
 
-        // Encontra o próximo número primo maior ou igual ao novo tamanho
-        new_size = get_next_prime(new_size);
+        // Encontra a próxima potência de 2 maior ou igual ao novo tamanho
+        new_size = next_power_of_two(new_size);
+        int new_shift = fibonacci_shift(new_size);
+
+        // Na política Robin Hood as entradas são recolocadas a partir das suas
+        // novas posições ideais
+        if constexpr (_robin_hood) {
+            std::vector<entry> old_table = std::move(_table);
+            _table = std::vector<entry>(new_size);
+            _table_size = new_size;
+            _shift = new_shift;
+            for (auto &e : old_table) {
+                if (e.state == OCCUPIED) {
+                    _counters.rehash_move();
+                    size_t index = home(e.hash_value);
+                    e.distance = 0;
+                    rh_place(std::move(e), index);
+                }
+            }
+            _keys_dirty = true;
+            return;
+        }
 
         // Cria uma nova tabela hash com o novo tamanho
         std::vector<entry> new_table(new_size);
 
         // Transfere as entradas da tabela antiga para a nova tabela
-        _comparisons++;
         for (size_t i = 0; i < _table_size; i++) {
-            _comparisons++;
             if (_table[i].state == OCCUPIED) {
+                _counters.rehash_move();
                 size_t j = 0;
                 size_t index;
+                // Usa o hash guardado na entrada, sem recalcular o hash
+                size_t h = _table[i].hash_value;
                 do {
-                    index =
-                        (_hash(_table[i].key) +
-                         j * (1 + (_hash(_table[i].key) % (new_size - 1)))) %
-                        new_size;
+                    index = (fibonacci_index(h, new_shift) +
+                             j * ((h << 1) | 1)) &
+                            (new_size - 1);
                     j++;
-                    _comparisons++;
                 } while (new_table[index].state == OCCUPIED);
 
-                new_table[index].key = _table[i].key;
-                new_table[index].value = _table[i].value;
-                new_table[index].state = OCCUPIED;
+                new_table[index] = std::move(_table[i]);
             }
         }
-        _comparisons++;
 
         _table_size = new_size;  // Atualiza o tamanho da tabela
+        _shift = new_shift;      // Atualiza o deslocamento do hashing
         _table =
             std::move(new_table);  // Atualiza o ponteiro para a nova tabela
         _keys_dirty = true;        // Marca as chaves como desatualizadas
     }
 
+    // Substitui o conteúdo da tabela pelos pares [first, last), que devem
+    // estar em ordem estritamente crescente de chave. A tabela é
+    // redimensionada uma única vez e os pares já ordenados viram a cópia
+    // ordenada das chaves, então a próxima iteração não precisa ordenar
+    template <typename iterator_t>
+    void assign_sorted(iterator_t first, iterator_t last) {
+        clear();
+        size_t n = last - first;
+        rehash(static_cast<size_t>(n / _max_load_factor) + 1);
+        for (iterator_t it = first; it != last; ++it) {
+            insert(it->first, it->second);
+        }
+        _sorted_keys.assign(first, last);
+        _keys_dirty = false;
+    }
+
     // Insere a chave k na tabela hash associada ao valor v
     bool insert(const key_t &k, const value_t &v) {
-        // Verifica se o fator de carga excedeu o máximo
-        _comparisons++;
-        if (load_factor() > _max_load_factor) {
-            rehash(2 * _table_size);
-        }
+        bool inserted;
+        _find_or_insert(k, v, inserted);
+        return inserted;
+    }
 
-        // Itera para encontrar um slot vazio ou a chave k
-        size_t i = 0;
-        size_t index;
-        do {
-            index = hash_code(k, i++);  // Calcula o índice da tabela hash
-            // Se o slot está vazio, insere a chave e o valor
-            _comparisons++;
-            if (_table[index].state != OCCUPIED) {
-                _table[index].key = k;
-                _table[index].value = v;
-                _table[index].state = OCCUPIED;
-                _number_of_elements++;
-                _keys_dirty = true;
-                return true;  // Chave inserida com sucesso
-            } else if (_table[index].key == k) {
-                _comparisons++;
-                return false;  // Chave já existe, não insere
-            }
+    // Insere a chave k na tabela hash, movendo-a para a entrada
+    bool insert(key_t &&k, const value_t &v) {
+        bool inserted;
+        _find_or_insert(std::move(k), v, inserted);
+        return inserted;
+    }
 
-            _comparisons++;
-        } while (i < _table_size);
+    // Constrói o par (chave, valor) a partir de args e o insere na tabela
+    // hash, movendo a chave e o valor para a entrada
+    template <typename... args_t>
+    bool emplace(args_t &&...args) {
+        std::pair<key_t, value_t> p(std::forward<args_t>(args)...);
+        bool inserted;
+        _find_or_insert(std::move(p.first), std::move(p.second), inserted);
+        return inserted;
+    }
+
+    // Retorna a referência para o valor associado à chave k, inserindo a chave
+    // com o valor v caso ela não exista (uma única sequência de sondagem)
+    value_t &find_or_insert(const key_t &k, const value_t &v) {
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
+        bool inserted;
+        return _find_or_insert(k, v, inserted);
+    }
 
-        return false;  // Tabela cheia, não insere
+    // Igual a find_or_insert, mas move a chave para a entrada (se inserida)
+    value_t &find_or_insert(key_t &&k, const value_t &v) {
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
+        bool inserted;
+        return _find_or_insert(std::move(k), v, inserted);
     }
 
     // Remove a chave k da tabela hash
     bool remove(const key_t &k) {
+        if constexpr (_robin_hood) {
+            size_t index = rh_find_index(k);
+            if (index == _table_size) {
+                return false;  // Chave não encontrada
+            }
+            rh_remove_at(index);
+            return true;  // Chave removida com sucesso
+        }
+
         // Itera para encontrar a chave k na tabela hash
+        size_t h = _hash(k);  // Hash da chave, calculado uma única vez
         size_t i = 0;
         size_t index;
         do {
-            index = hash_code(k, i++);  // Calcula o índice da tabela hash
-            _comparisons++;
+            _counters.probe();
+            index = hash_code(h, i++);  // Calcula o índice da tabela hash
             if (_table[index].state == EMPTY) {
                 return false;  // Chave não encontrada
             }
             // Se a chave foi encontrada, remove a entrada
             else if (_table[index].state == OCCUPIED &&
-                     _table[index].key == k) {
-                _comparisons++;
+                     _table[index].hash_value == h &&
+                     _equal(_table[index].key, k)) {
                 _table[index].state = DELETED;
                 _number_of_elements--;
                 _keys_dirty = true;
                 return true;  // Chave removida com sucesso
             }
-            _comparisons++;
         } while (i < _table_size);
 
         return false;  // Chave não encontrada
@@ -277,44 +475,92 @@ class open_hash_table {
 
     // Retorna a referência para o valor associado a uma chave
     value_t &search(const key_t &k) {
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
+        if constexpr (_robin_hood) {
+            size_t index = rh_find_index(k);
+            if (index == _table_size) {
+                throw std::out_of_range("Key not found");
+            }
+            return _table[index].value;
+        }
+
         // Itera para encontrar a chave k na tabela hash
+        size_t h = _hash(k);  // Hash da chave, calculado uma única vez
         size_t i = 0;
         size_t index;
         do {
-            index = hash_code(k, i++);  // Calcula o índice da tabela hash
+            _counters.probe();
+            index = hash_code(h, i++);  // Calcula o índice da tabela hash
             // Se o slot está vazio, a chave não existe
-            _comparisons++;
             if (_table[index].state == EMPTY) {
                 break;
             }
             // Se a chave foi encontrada, retorna o valor associado
             else if (_table[index].state == OCCUPIED &&
-                     _table[index].key == k) {
-                _comparisons++;
+                     _table[index].hash_value == h &&
+                     _equal(_table[index].key, k)) {
                 return _table[index].value;
             }
 
-            _comparisons++;
         } while (i < _table_size);
 
         // Se a chave não foi encontrada, lança uma exceção
         throw std::out_of_range("Key not found");
     }
 
+    // Retorna um ponteiro para o valor associado a uma chave, ou nullptr caso a
+    // chave não exista
+    value_t *find(const key_t &k) {
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
+        if constexpr (_robin_hood) {
+            size_t index = rh_find_index(k);
+            return index == _table_size ? nullptr : &_table[index].value;
+        }
+
+        // Itera para encontrar a chave k na tabela hash
+        size_t h = _hash(k);  // Hash da chave, calculado uma única vez
+        size_t i = 0;
+        size_t index;
+        do {
+            _counters.probe();
+            index = hash_code(h, i++);  // Calcula o índice da tabela hash
+            // Se o slot está vazio, a chave não existe
+            if (_table[index].state == EMPTY) {
+                break;
+            }
+            // Se a chave foi encontrada, retorna o valor associado
+            else if (_table[index].state == OCCUPIED &&
+                     _table[index].hash_value == h &&
+                     _equal(_table[index].key, k)) {
+                return &_table[index].value;
+            }
+
+        } while (i < _table_size);
+
+        return nullptr;  // Chave não encontrada
+    }
+
     // Verifica se a chave k está na tabela hash
     bool contains(const key_t &k) const {
+        if constexpr (_robin_hood) {
+            return rh_find_index(k) != _table_size;
+        }
+
         // Itera para encontrar a chave k na tabela hash
+        size_t h = _hash(k);  // Hash da chave, calculado uma única vez
         size_t i = 0;
         size_t index;
         do {
-            index = hash_code(k, i++);  // Calcula o índice da tabela hash
+            _counters.probe();
+            index = hash_code(h, i++);  // Calcula o índice da tabela hash
             // Se o slot está vazio, a chave não existe
             if (_table[index].state == EMPTY) {
                 return false;
             }
             // Se a chave foi encontrada, retorna verdadeiro
             else if (_table[index].state == OCCUPIED &&
-                     _table[index].key == k) {
+                     _table[index].hash_value == h &&
+                     _equal(_table[index].key, k)) {
                 return true;
             }
         } while (i < _table_size);
@@ -323,24 +569,46 @@ class open_hash_table {
     }
 
     void att(const key_t &k, const value_t &v) {
+        _keys_dirty = true;  // Marca as chaves como desatualizadas
+        if constexpr (_robin_hood) {
+            size_t index = rh_find_index(k);
+            if (index == _table_size) {
+                throw std::out_of_range("Key not found");
+            }
+            _table[index].value = v;
+            return;
+        }
+
         // Itera para encontrar a chave k na tabela hash
+        size_t h = _hash(k);  // Hash da chave, calculado uma única vez
         size_t i = 0;
         size_t index;
         do {
-            index = hash_code(k, i++);  // Calcula o índice da tabela hash
+            _counters.probe();
+            index = hash_code(h, i++);  // Calcula o índice da tabela hash
             // A chave foi encontrada, atualiza o valor associado
-            _comparisons++;
-            if (_table[index].state == OCCUPIED && _table[index].key == k) {
+            if (_table[index].state == OCCUPIED &&
+                _table[index].hash_value == h && _equal(_table[index].key, k)) {
                 _table[index].value = v;
                 return;
             }
-            _comparisons++;
         } while (i < _table_size);
 
         // Se a chave não foi encontrada, lança uma exceção
         throw std::out_of_range("Key not found");
     }
 
+    // Percorre todos os pares da tabela na ordem em que estão armazenados
+    // (sem ordenar as chaves), chamando f(chave, valor)
+    template <typename function>
+    void for_each(function f) const {
+        for (const auto &entry : _table) {
+            if (entry.state == OCCUPIED) {
+                f(entry.key, entry.value);
+            }
+        }
+    }
+
     // Classe de iterador para percorrer as chaves da tabela hash
     // O Iterador não acessa diretamente a tabela hash, mas sim um vetor de
     // chaves ordenadas
@@ -372,7 +640,7 @@ class open_hash_table {
         }
 
         // Sobrecarga do operador de seta para acessar o ponteiro para o par
-        std::pair<key_t, value_t> *operator->() const {
+        const std::pair<key_t, value_t> *operator->() const {
             return &_ht->_sorted_keys[_index];
         }
     };
@@ -399,6 +667,62 @@ class open_hash_table {
         return iterator(this, _sorted_keys.size());
     }
 
-    // Retorna o número de comparações realizadas
-    unsigned int comparisons() const { return _comparisons; }
+    // Retorna os contadores de operações
+    const counting &counters() const { return _counters; }
+
+    // Retorna a memória usada pela tabela, separada por categoria. As
+    // entradas removidas (DELETED) ainda guardam a chave, então a memória das
+    // chaves é somada em todas as entradas
+    memory_breakdown memory_usage() const {
+        memory_breakdown usage;
+        usage.nodes = _number_of_elements * sizeof(entry);
+        for (const auto &e : _table) {
+            usage.key_heap += heap_bytes(e.key) + heap_bytes(e.value);
+        }
+        usage.buckets =
+            (_table.capacity() - _number_of_elements) * sizeof(entry);
+        usage.sorted_keys = sorted_keys_bytes(_sorted_keys);
+        return usage;
+    }
+
+    // Retorna as estatísticas de distribuição da tabela: o histograma do
+    // número de posições visitadas para encontrar cada chave e, no hashing
+    // duplo, o histograma do número de entradas removidas (DELETED)
+    // atravessadas nessas buscas
+    structure_stats stats() const {
+        structure_stats s;
+        histogram probes, crossed;
+        uint64_t deleted = 0;
+        for (size_t index = 0; index < _table_size; index++) {
+            const entry &e = _table[index];
+            if (e.state == DELETED) {
+                deleted++;
+            }
+            if (e.state != OCCUPIED) {
+                continue;
+            }
+
+            if constexpr (_robin_hood) {
+                probes.add(e.distance + 1);
+            } else {
+                // Refaz a sequência de sondagem da chave até a sua posição
+                size_t i = 0;
+                size_t deleted_in_path = 0;
+                for (; hash_code(e.hash_value, i) != index; i++) {
+                    if (_table[hash_code(e.hash_value, i)].state == DELETED) {
+                        deleted_in_path++;
+                    }
+                }
+                probes.add(i + 1);
+                crossed.add(deleted_in_path);
+            }
+        }
+
+        s.histograms.push_back({"comprimento das sondagens", probes});
+        if constexpr (!_robin_hood) {
+            s.values.push_back({"entradas removidas (DELETED)", deleted});
+            s.histograms.push_back({"entradas DELETED atravessadas", crossed});
+        }
+        return s;
+    }
 };
@@ -0,0 +1,569 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../counting.hpp"
+#include "../memory_usage.hpp"
+#include "../statistics.hpp"
+
+// Classe que implementa uma tabela hash com endereçamento aberto no estilo
+// "Swiss table": além do vetor de slots, a tabela mantém um vetor de bytes de
+// controle (um por slot) com 7 bits do hash de cada chave. A sondagem é feita
+// em grupos de 16 slots, comparando os 16 bytes de controle de uma só vez
+// (SSE2), e a chave só é comparada nos slots cujo byte de controle coincide.
+// A política counting define se as operações são contadas
+template <typename key_t, typename value_t, typename hash = std::hash<key_t>,
+          typename compare = std::less<key_t>,
+          typename counting = default_counting_policy>
+class swiss_hash_table {
+   private:
+    // Valores especiais dos bytes de controle (slots ocupados guardam os 7
+    // bits do hash, entre 0 e 127)
+    static constexpr int8_t EMPTY = -128;  // Slot vazio
+    static constexpr int8_t DELETED = -2;  // Slot removido
+
+    static constexpr size_t GROUP_WIDTH = 16;  // Slots por grupo
+
+    // Grupo de 16 bytes de controle, com buscas que retornam uma máscara de
+    // bits (bit i ligado = slot i do grupo satisfaz a busca)
+    struct group {
+#ifdef __SSE2__
+        __m128i ctrl;
+
+        explicit group(const int8_t* p)
+            : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) {}
+
+        // Slots cujo byte de controle é igual a h2
+        uint32_t match(int8_t h2) const {
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+        }
+
+        // Slots vazios ou removidos (bit de sinal ligado)
+        uint32_t match_free() const { return _mm_movemask_epi8(ctrl); }
+#else
+        const int8_t* ctrl;
+
+        explicit group(const int8_t* p) : ctrl(p) {}
+
+        // Slots cujo byte de controle é igual a h2
+        uint32_t match(int8_t h2) const {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; i++) {
+                mask |= static_cast<uint32_t>(ctrl[i] == h2) << i;
+            }
+            return mask;
+        }
+
+        // Slots vazios ou removidos (bit de sinal ligado)
+        uint32_t match_free() const {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; i++) {
+                mask |= static_cast<uint32_t>(ctrl[i] < 0) << i;
+            }
+            return mask;
+        }
+#endif
+
+        // Slots vazios
+        uint32_t match_empty() const { return match(EMPTY); }
+    };
+
+    size_t _number_of_elements;  // Número de elementos na tabela hash
+    size_t _number_of_deleted;   // Número de slots removidos
+    size_t _table_size;          // Número de slots (múltiplo de 16)
+    size_t _group_mask;          // Número de grupos - 1 (potência de 2)
+    int _group_shift;            // Deslocamento para obter o grupo do hash
+    std::vector<int8_t> _ctrl;   // Bytes de controle
+    std::vector<std::pair<key_t, value_t>> _slots;  // Pares (chave, valor)
+    float _max_load_factor;  // Fator de carga máximo permitido
+    hash _hash;              // Função de hash
+    compare _compare;        // Functor de comparação
+
+    // Vetor de chaves ordenadas (para iteradores)
+    std::vector<std::pair<key_t, value_t>> _sorted_keys;
+
+    // Flag para indicar se o vetor de chaves ordenadas está desatualizado
+    bool _keys_dirty;
+
+    mutable counting _counters;  // Contadores de operações
+
+    // Compara duas chaves por igualdade, contando a comparação
+    bool _equal(const key_t& a, const key_t& b) const {
+        _counters.comparison();
+        return a == b;
+    }
+
+    // Calcula o menor número de slots (potência de 2, no mínimo um grupo)
+    // capaz de guardar x slots
+    static size_t round_size(size_t x) {
+        size_t size = GROUP_WIDTH;
+        while (size < x) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    // Espalha os bits do hash (hashing multiplicativo de Fibonacci)
+    size_t mixed_hash(const key_t& k) const {
+        return static_cast<uint64_t>(_hash(k)) * 0x9E3779B97F4A7C15ull;
+    }
+
+    // Os 7 bits mais altos do hash vão para o byte de controle
+    static int8_t h2(size_t h) { return static_cast<int8_t>(h >> 57); }
+
+    // Os bits logo abaixo escolhem o grupo inicial da sondagem
+    size_t h1(size_t h) const { return (h >> _group_shift) & _group_mask; }
+
+    // Procura a chave k, retornando o seu slot ou _table_size caso a chave não
+    // exista. Os grupos são visitados em sondagem triangular, que passa por
+    // todos os grupos quando o número de grupos é potência de 2
+    size_t find_slot(const key_t& k, size_t h) {
+        size_t g = h1(h);
+        int8_t tag = h2(h);
+        for (size_t step = 1;; step++) {
+            _counters.probe();
+            group current(&_ctrl[g * GROUP_WIDTH]);
+
+            // Compara a chave apenas nos slots com o mesmo byte de controle
+            for (uint32_t bits = current.match(tag); bits != 0;
+                 bits &= bits - 1) {
+                size_t slot = g * GROUP_WIDTH + __builtin_ctz(bits);
+                if (_equal(_slots[slot].first, k)) {
+                    return slot;
+                }
+            }
+
+            // Um slot vazio no grupo encerra a sondagem
+            if (current.match_empty() != 0) {
+                return _table_size;
+            }
+            g = (g + step) & _group_mask;
+        }
+    }
+
+    // Procura o primeiro slot livre (vazio ou removido) na sequência de
+    // sondagem do hash h
+    size_t find_free_slot(size_t h) const {
+        size_t g = h1(h);
+        for (size_t step = 1;; step++) {
+            _counters.probe();
+            uint32_t bits = group(&_ctrl[g * GROUP_WIDTH]).match_free();
+            if (bits != 0) {
+                return g * GROUP_WIDTH + __builtin_ctz(bits);
+            }
+            g = (g + step) & _group_mask;
+        }
+    }
+
+    // Recria a tabela com new_size slots, reinserindo os elementos e
+    // descartando os slots removidos
+    void resize(size_t new_size) {
+        std::vector<int8_t> old_ctrl = std::move(_ctrl);
+        std::vector<std::pair<key_t, value_t>> old_slots = std::move(_slots);
+        _ctrl.assign(new_size, EMPTY);
+        _slots = std::vector<std::pair<key_t, value_t>>(new_size);
+
+        size_t old_size = _table_size;
+        _table_size = new_size;
+        _group_mask = new_size / GROUP_WIDTH - 1;
+        _group_shift = 57;
+        for (size_t groups = _group_mask + 1; groups > 1; groups /= 2) {
+            _group_shift--;
+        }
+        _number_of_deleted = 0;
+
+        // Transfere os elementos da tabela antiga para a nova tabela
+        for (size_t i = 0; i < old_size; i++) {
+            if (old_ctrl[i] >= 0) {
+                _counters.rehash_move();
+                size_t h = mixed_hash(old_slots[i].first);
+                size_t slot = find_free_slot(h);
+                _ctrl[slot] = h2(h);
+                _slots[slot] = std::move(old_slots[i]);
+            }
+        }
+        _keys_dirty = true;  // Marca as chaves como desatualizadas
+    }
+
+    // Garante espaço para mais um elemento, crescendo a tabela quando o fator
+    // de carga (contando os slots removidos) excede o máximo
+    void reserve_one() {
+        if (_number_of_elements + _number_of_deleted + 1 >
+            _max_load_factor * _table_size) {
+            // Se muitos slots estão removidos, basta limpar a tabela
+            if (_number_of_deleted > _number_of_elements) {
+                resize(_table_size);
+            } else {
+                resize(2 * _table_size);
+            }
+        }
+    }
+
+    // Ocupa um slot livre com a chave k e o valor v (copiados ou movidos)
+    template <typename key_arg, typename value_arg>
+    size_t insert_slot(key_arg&& k, value_arg&& v, size_t h) {
+        size_t slot = find_free_slot(h);
+        if (_ctrl[slot] == DELETED) {
+            _number_of_deleted--;
+        }
+        _ctrl[slot] = h2(h);
+        _slots[slot].first = std::forward<key_arg>(k);
+        _slots[slot].second = std::forward<value_arg>(v);
+        _number_of_elements++;
+        _keys_dirty = true;
+        return slot;
+    }
+
+    // Atualiza o vetor de chaves ordenadas
+    void update_sorted_keys() {
+        // Limpa o vetor de chaves ordenadas
+        _sorted_keys.clear();
+        _sorted_keys.reserve(_number_of_elements);
+
+        // Adiciona cada slot ocupado ao vetor de chaves
+        for (size_t i = 0; i < _table_size; i++) {
+            if (_ctrl[i] >= 0) {
+                _sorted_keys.push_back(_slots[i]);
+            }
+        }
+
+        // Ordena o vetor de chaves usando o comparador
+        std::sort(_sorted_keys.begin(), _sorted_keys.end(),
+                  [this](const std::pair<key_t, value_t>& a,
+                         const std::pair<key_t, value_t>& b) -> bool {
+                      return _compare(a.first, b.first);
+                  });
+
+        _keys_dirty = false;  // Marca as chaves como atualizadas
+    }
+
+    // Insere a chave k com o valor v caso ela não exista
+    template <typename key_arg, typename value_arg>
+    bool _insert(key_arg&& k, value_arg&& v) {
+        reserve_one();
+        size_t h = mixed_hash(k);
+        if (find_slot(k, h) != _table_size) {
+            return false;  // Chave já existe, não insere
+        }
+        insert_slot(std::forward<key_arg>(k), std::forward<value_arg>(v), h);
+        return true;
+    }
+
+    // Retorna o valor da chave k, inserindo-a com o valor v caso não exista
+    template <typename key_arg>
+    value_t& _find_or_insert(key_arg&& k, const value_t& v) {
+        reserve_one();
+        size_t h = mixed_hash(k);
+        size_t slot = find_slot(k, h);
+        if (slot == _table_size) {
+            slot = insert_slot(std::forward<key_arg>(k), v, h);
+        }
+        return _slots[slot].second;
+    }
+
+   public:
+    using key_type = key_t;       // Tipo das chaves
+    using mapped_type = value_t;  // Tipo dos valores
+    using key_compare = compare;  // Ordem das chaves
+
+    // Construtor da tabela hash
+    swiss_hash_table(size_t table_size = 16, const hash& hf = hash())
+        : _number_of_elements(0),
+          _number_of_deleted(0),
+          _table_size(0),
+          _max_load_factor(0.875),
+          _hash(hf),
+          _compare(compare()),
+          _sorted_keys(),
+          _keys_dirty(true),
+          _counters() {
+        resize(round_size(table_size));
+    }
+
+    // Retorna o número de slots na tabela hash
+    size_t bucket_count() const { return _table_size; }
+
+    // Retorna o fator de carga atual da tabela hash
+    float load_factor() const {
+        return static_cast<float>(_number_of_elements) / _table_size;
+    }
+
+    // Retorna o fator de carga máximo permitido
+    float max_load_factor() const { return _max_load_factor; }
+
+    // Define o fator de carga máximo permitido
+    void max_load_factor(float lf) {
+        // Deve sobrar ao menos um slot vazio para encerrar as sondagens
+        if (lf <= 0 || lf >= 1) {
+            throw std::out_of_range("max load factor out of range");
+        }
+        _max_load_factor = lf;
+    }
+
+    // Redimensiona a tabela hash para pelo menos new_size slots
+    void rehash(size_t new_size) {
+        // Se o novo tamanho for menor ou igual ao atual, não faz nada
+        if (new_size <= _table_size) {
+            return;
+        }
+        resize(round_size(new_size));
+    }
+
+    // Substitui o conteúdo da tabela pelos pares [first, last), que devem
+    // estar em ordem estritamente crescente de chave. A tabela é
+    // redimensionada uma única vez e os pares já ordenados viram a cópia
+    // ordenada das chaves, então a próxima iteração não precisa ordenar
+    template <typename iterator_t>
+    void assign_sorted(iterator_t first, iterator_t last) {
+        clear();
+        size_t n = last - first;
+        rehash(static_cast<size_t>(n / _max_load_factor) + 1);
+        for (iterator_t it = first; it != last; ++it) {
+            insert(it->first, it->second);
+        }
+        _sorted_keys.assign(first, last);
+        _keys_dirty = false;
+    }
+
+    // Insere a chave k na tabela hash associada ao valor v
+    bool insert(const key_t& k, const value_t& v) {
+        return _insert(k, v);
+    }
+
+    // Insere a chave k na tabela hash, movendo-a para o slot
+    bool insert(key_t&& k, const value_t& v) {
+        return _insert(std::move(k), v);
+    }
+
+    // Constrói o par (chave, valor) a partir de args e o insere na tabela
+    // hash, movendo a chave e o valor para o slot
+    template <typename... args_t>
+    bool emplace(args_t&&... args) {
+        std::pair<key_t, value_t> p(std::forward<args_t>(args)...);
+        return _insert(std::move(p.first), std::move(p.second));
+    }
+
+    // Retorna a referência para o valor associado à chave k, inserindo a chave
+    // com o valor v caso ela não exista
+    value_t& find_or_insert(const key_t& k, const value_t& v) {
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
+        return _find_or_insert(k, v);
+    }
+
+    // Igual a find_or_insert, mas move a chave para o slot (se inserida)
+    value_t& find_or_insert(key_t&& k, const value_t& v) {
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
+        return _find_or_insert(std::move(k), v);
+    }
+
+    // Remove a chave k da tabela hash
+    bool remove(const key_t& k) {
+        size_t slot = find_slot(k, mixed_hash(k));
+        if (slot == _table_size) {
+            return false;  // Chave não encontrada
+        }
+
+        // Se o grupo já tem um slot vazio, nenhuma sondagem passa por ele, e
+        // o slot pode voltar a ser vazio; senão vira um slot removido
+        size_t g = slot / GROUP_WIDTH;
+        if (group(&_ctrl[g * GROUP_WIDTH]).match_empty() != 0) {
+            _ctrl[slot] = EMPTY;
+        } else {
+            _ctrl[slot] = DELETED;
+            _number_of_deleted++;
+        }
+        _slots[slot] = std::pair<key_t, value_t>();
+        _number_of_elements--;
+        _keys_dirty = true;
+        return true;
+    }
+
+    // Limpa todos os elementos da tabela hash
+    void clear() {
+        std::fill(_ctrl.begin(), _ctrl.end(), EMPTY);
+        std::fill(_slots.begin(), _slots.end(), std::pair<key_t, value_t>());
+        _number_of_elements = 0;
+        _number_of_deleted = 0;
+        _keys_dirty = true;
+    }
+
+    // Retorna o número de elementos na tabela hash
+    size_t size() const { return _number_of_elements; }
+
+    // Verifica se a tabela hash está vazia
+    bool empty() const { return _number_of_elements == 0; }
+
+    // Retorna a referência para o valor associado a uma chave
+    value_t& search(const key_t& k) {
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
+        size_t slot = find_slot(k, mixed_hash(k));
+        if (slot != _table_size) {
+            return _slots[slot].second;
+        }
+
+        // Se a chave não foi encontrada, lança uma exceção
+        throw std::out_of_range("Key not found");
+    }
+
+    // Retorna um ponteiro para o valor associado a uma chave, ou nullptr caso a
+    // chave não exista
+    value_t* find(const key_t& k) {
+        _keys_dirty = true;  // O valor pode ser alterado pela referência
+        size_t slot = find_slot(k, mixed_hash(k));
+        if (slot != _table_size) {
+            return &_slots[slot].second;
+        }
+        return nullptr;
+    }
+
+    // Verifica se a chave k está na tabela hash
+    bool contains(const key_t& k) {
+        return find_slot(k, mixed_hash(k)) != _table_size;
+    }
+
+    // Atualiza o valor associado à chave k
+    void att(const key_t& k, const value_t& v) {
+        size_t slot = find_slot(k, mixed_hash(k));
+        if (slot != _table_size) {
+            _slots[slot].second = v;
+            _keys_dirty = true;
+            return;
+        }
+
+        // Se a chave não foi encontrada, lança uma exceção
+        throw std::out_of_range("Key not found");
+    }
+
+    // Percorre todos os pares da tabela na ordem em que estão armazenados
+    // (sem ordenar as chaves), chamando f(chave, valor)
+    template <typename function>
+    void for_each(function f) const {
+        for (size_t i = 0; i < _table_size; i++) {
+            if (_ctrl[i] >= 0) {
+                f(_slots[i].first, _slots[i].second);
+            }
+        }
+    }
+
+    // Classe de iterador para percorrer as chaves da tabela hash
+    // O Iterador não acessa diretamente a tabela hash, mas sim um vetor de
+    // chaves ordenadas
+    class iterator {
+       private:
+        const swiss_hash_table* _ht;  // Ponteiro para a tabela hash
+        size_t _index;  // Índice atual do vetor de chaves ordenadas
+
+       public:
+        // Construtor do iterador
+        iterator(const swiss_hash_table* ht, size_t index)
+            : _ht(ht), _index(index) {}
+
+        // Sobrecarga do operador de desreferência para acessar o par (chave,
+        // valor)
+        const std::pair<key_t, value_t>& operator*() const {
+            return _ht->_sorted_keys[_index];
+        }
+
+        // Sobrecarga do operador de incremento para avançar o iterador
+        iterator& operator++() {
+            _index++;
+            return *this;
+        }
+
+        // Sobrecarga do operador de desigualdade para comparar dois iteradores
+        bool operator!=(const iterator& other) const {
+            return _index != other._index;
+        }
+
+        // Sobrecarga do operador de seta para acessar o ponteiro para o par
+        const std::pair<key_t, value_t>* operator->() const {
+            return &_ht->_sorted_keys[_index];
+        }
+    };
+
+    // Retorna um iterador para o início do vetor de chaves ordenadas
+    iterator begin() {
+        // Se o vetor de chaves ordenadas estiver desatualizado, atualiza
+        if (_keys_dirty) {
+            update_sorted_keys();
+        }
+
+        // Cria um iterador para o início do vetor de chaves ordenadas
+        return iterator(this, 0);
+    }
+
+    // Retorna um iterador para o final do vetor de chaves ordenadas
+    iterator end() {
+        // Se o vetor de chaves ordenadas estiver desatualizado, atualiza
+        if (_keys_dirty) {
+            update_sorted_keys();
+        }
+
+        // Cria um iterador para o final do vetor de chaves ordenadas
+        return iterator(this, _sorted_keys.size());
+    }
+
+    // Retorna os contadores de operações
+    const counting& counters() const { return _counters; }
+
+    // Retorna a memória usada pela tabela, separada por categoria. Os slots
+    // livres e os bytes de controle entram como overhead dos buckets
+    memory_breakdown memory_usage() const {
+        using slot = std::pair<key_t, value_t>;
+        memory_breakdown usage;
+        usage.nodes = _number_of_elements * sizeof(slot);
+        for (const auto& s : _slots) {
+            usage.key_heap += heap_bytes(s.first) + heap_bytes(s.second);
+        }
+        usage.buckets =
+            (_slots.capacity() - _number_of_elements) * sizeof(slot) +
+            _ctrl.capacity();
+        usage.sorted_keys = sorted_keys_bytes(_sorted_keys);
+        return usage;
+    }
+
+    // Retorna as estatísticas de distribuição da tabela: o histograma do
+    // número de grupos visitados para encontrar cada chave e o histograma do
+    // número de slots removidos (DELETED) nos grupos atravessados antes do
+    // grupo da chave
+    structure_stats stats() const {
+        structure_stats s;
+        histogram groups, crossed;
+        for (size_t slot = 0; slot < _table_size; slot++) {
+            if (_ctrl[slot] < 0) {
+                continue;
+            }
+
+            // Refaz a sondagem triangular até o grupo do slot
+            size_t h = mixed_hash(_slots[slot].first);
+            size_t g = h1(h);
+            size_t visited = 1;
+            size_t deleted_in_path = 0;
+            for (size_t step = 1; g != slot / GROUP_WIDTH; step++) {
+                for (size_t i = 0; i < GROUP_WIDTH; i++) {
+                    deleted_in_path += _ctrl[g * GROUP_WIDTH + i] == DELETED;
+                }
+                g = (g + step) & _group_mask;
+                visited++;
+            }
+            groups.add(visited);
+            crossed.add(deleted_in_path);
+        }
+
+        s.values.push_back({"slots removidos (DELETED)", _number_of_deleted});
+        s.histograms.push_back({"grupos visitados", groups});
+        s.histograms.push_back({"slots DELETED atravessados", crossed});
+        return s;
+    }
+};
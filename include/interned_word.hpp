@@ -0,0 +1,235 @@
+#pragma once
+
+#include <unicode/coll.h>
+#include <unicode/unistr.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "compare.hpp"
+
+class word_arena;
+
+// Registro de uma palavra na arena: um cabeçalho seguido dos caracteres da
+// palavra em UTF-16. A sort key é calculada na primeira comparação e também
+// fica guardada na arena
+struct word_record {
+    word_arena* arena;                   // Arena que guarda o registro
+    mutable const uint8_t* sort_key;     // Sort key (nullptr se não calculada)
+    mutable int32_t sort_key_length;     // Tamanho da sort key em bytes
+    uint32_t hash;                       // Hash da palavra
+    int32_t length;                      // Tamanho em unidades UTF-16
+
+    // Caracteres da palavra, guardados logo depois do cabeçalho
+    const char16_t* chars() const {
+        return reinterpret_cast<const char16_t*>(this + 1);
+    }
+};
+
+// Chave compacta das estruturas: um único ponteiro para o registro da palavra
+// na arena (o registro guarda o tamanho e o hash). Cópias da chave não copiam
+// a palavra, então a cópia ordenada das chaves das tabelas hash também fica
+// pequena
+class interned_word {
+   private:
+    const word_record* _record;
+
+   public:
+    interned_word() : _record(nullptr) {}
+
+    explicit interned_word(const word_record* record) : _record(record) {}
+
+    const word_record* record() const { return _record; }
+
+    const char16_t* data() const { return _record->chars(); }
+
+    int32_t length() const { return _record->length; }
+
+    uint32_t hash() const { return _record->hash; }
+
+    // Retorna a palavra como uma UnicodeString somente leitura que aponta
+    // para os caracteres da arena (sem cópia)
+    icu::UnicodeString word() const {
+        return icu::UnicodeString(false, data(), length());
+    }
+
+    // Permite usar a chave onde se espera a palavra (listagem)
+    operator icu::UnicodeString() const { return word(); }
+
+    // Igualdade pela palavra (registros diferentes podem ter a mesma palavra)
+    bool operator==(const interned_word& other) const {
+        if (_record == other._record) {
+            return true;
+        }
+        if (_record == nullptr || other._record == nullptr) {
+            return false;
+        }
+        return hash() == other.hash() && length() == other.length() &&
+               std::memcmp(data(), other.data(),
+                           length() * sizeof(char16_t)) == 0;
+    }
+
+    bool operator!=(const interned_word& other) const {
+        return !(*this == other);
+    }
+};
+
+// Arena de palavras: os registros são adicionados ao final de blocos que
+// nunca são realocados, então os ponteiros para os registros continuam
+// válidos até a destruição da arena. Apenas o último registro pode ser
+// desfeito (rollback), o que permite internar uma palavra para buscá-la e
+// descartá-la caso ela já esteja na estrutura
+class word_arena {
+   private:
+    static constexpr size_t block_size = 64 * 1024;  // Bytes por bloco
+
+    std::vector<std::unique_ptr<char[]>> _blocks;  // Blocos alocados
+    size_t _capacity;  // Capacidade do último bloco
+    size_t _used;      // Bytes usados do último bloco
+    size_t _total;     // Bytes reservados em todos os blocos
+
+    // Último registro adicionado e a posição do último bloco onde ele começa
+    // (nullptr se algo foi guardado depois dele e ele não pode ser desfeito)
+    const word_record* _last;
+    size_t _last_offset;
+
+    // Reserva bytes alinhados a 8 bytes no último bloco, alocando um novo
+    // bloco se necessário
+    char* _allocate(size_t bytes) {
+        bytes = (bytes + 7) & ~size_t(7);
+        if (_blocks.empty() || _used + bytes > _capacity) {
+            _capacity = std::max(block_size, bytes);
+            _blocks.emplace_back(new char[_capacity]);
+            _total += _capacity;
+            _used = 0;
+        }
+        char* p = _blocks.back().get() + _used;
+        _used += bytes;
+        return p;
+    }
+
+   public:
+    word_arena()
+        : _blocks(), _capacity(0), _used(0), _total(0), _last(nullptr),
+          _last_offset(0) {}
+
+    // Os registros guardam o endereço da arena, então ela não é copiada nem
+    // movida
+    word_arena(const word_arena&) = delete;
+    word_arena& operator=(const word_arena&) = delete;
+
+    // Adiciona a palavra (length unidades UTF-16) à arena
+    interned_word intern(const char16_t* chars, int32_t length) {
+        char* p = _allocate(sizeof(word_record) + length * sizeof(char16_t));
+        word_record* record = reinterpret_cast<word_record*>(p);
+        record->arena = this;
+        record->sort_key = nullptr;
+        record->sort_key_length = 0;
+        record->length = length;
+
+        // Hash FNV-1a das unidades UTF-16
+        uint32_t hash = 2166136261u;
+        char16_t* dest = reinterpret_cast<char16_t*>(record + 1);
+        for (int32_t i = 0; i < length; i++) {
+            dest[i] = chars[i];
+            hash = (hash ^ chars[i]) * 16777619u;
+        }
+        record->hash = hash;
+
+        _last = record;
+        _last_offset = p - _blocks.back().get();
+        return interned_word(record);
+    }
+
+    interned_word intern(const icu::UnicodeString& word) {
+        return intern(word.getBuffer(), word.length());
+    }
+
+    // Copia para esta arena uma palavra de outra arena
+    interned_word intern(const interned_word& word) {
+        return intern(word.data(), word.length());
+    }
+
+    // Desfaz o último registro adicionado, caso nada tenha sido guardado na
+    // arena depois dele (a sort key do próprio registro pode ter sido)
+    void rollback(const interned_word& word) {
+        if (word.record() == _last && _last != nullptr) {
+            _used = _last_offset;
+            _last = nullptr;
+        }
+    }
+
+    // Guarda a sort key de um registro da arena
+    void store_sort_key(const word_record* record, const uint8_t* key,
+                        int32_t length) {
+        size_t blocks = _blocks.size();
+        uint8_t* p = reinterpret_cast<uint8_t*>(_allocate(length));
+        std::memcpy(p, key, length);
+        record->sort_key = p;
+        record->sort_key_length = length;
+
+        // O último registro não pode mais ser desfeito sem perder esta sort
+        // key (de outro registro ou guardada em um novo bloco)
+        if (record != _last || _blocks.size() != blocks) {
+            _last = nullptr;
+        }
+    }
+
+    // Libera todos os blocos (os registros deixam de ser válidos)
+    void clear() {
+        _blocks.clear();
+        _capacity = _used = _total = 0;
+        _last = nullptr;
+    }
+
+    // Retorna os bytes usados pelos registros e sort keys
+    size_t used_bytes() const { return _total - (_capacity - _used); }
+
+    // Retorna os bytes reservados por todos os blocos
+    size_t reserved_bytes() const { return _total; }
+};
+
+// Hash das palavras internadas: o hash já calculado na arena
+struct interned_hash {
+    size_t operator()(const interned_word& w) const { return w.hash(); }
+};
+
+// Functor para comparar palavras internadas pelas suas sort keys do ICU
+// Collator. Cada sort key é calculada uma única vez e guardada na arena da
+// palavra; as comparações seguintes são comparações de bytes (memcmp)
+struct interned_compare : unicode_compare {
+    mutable std::vector<uint8_t> _buffer;  // Buffer para calcular sort keys
+
+    // Calcula a sort key da palavra, caso ainda não exista
+    const word_record* sorted(const interned_word& w) const {
+        const word_record* record = w.record();
+        if (record->sort_key == nullptr) {
+            int32_t capacity = 4 * record->length + 16;
+            _buffer.resize(capacity);
+            int32_t length = collator->getSortKey(
+                record->chars(), record->length, _buffer.data(), capacity);
+            if (length > capacity) {
+                _buffer.resize(length);
+                collator->getSortKey(record->chars(), record->length,
+                                     _buffer.data(), length);
+            }
+            // A sort key termina com um byte zero, que não é guardado
+            record->arena->store_sort_key(record, _buffer.data(), length - 1);
+        }
+        return record;
+    }
+
+    bool operator()(const interned_word& lhs, const interned_word& rhs) const {
+        const word_record* a = sorted(lhs);
+        const word_record* b = sorted(rhs);
+        int32_t n = std::min(a->sort_key_length, b->sort_key_length);
+        int result = std::memcmp(a->sort_key, b->sort_key, n);
+        return result < 0 ||
+               (result == 0 && a->sort_key_length < b->sort_key_length);
+    }
+};
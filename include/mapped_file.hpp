@@ -0,0 +1,69 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <string>
+
+// Arquivo mapeado em memória somente para leitura (mmap). O conteúdo é lido
+// diretamente das páginas mapeadas, sem cópia para um buffer na heap. O
+// mapeamento é desfeito no destrutor.
+class mapped_file {
+   private:
+    const char* _data;  // Início do mapeamento (nullptr se vazio)
+    size_t _size;       // Tamanho do arquivo em bytes
+    bool _open;         // Indica se o arquivo foi aberto com sucesso
+
+   public:
+    // Abre e mapeia o arquivo, avisando o kernel que a leitura é sequencial
+    explicit mapped_file(const std::string& path)
+        : _data(nullptr), _size(0), _open(false) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0) {
+            _size = static_cast<size_t>(st.st_size);
+            _open = true;
+
+            // Arquivos vazios não podem ser mapeados
+            if (_size > 0) {
+                void* p = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED) {
+                    _size = 0;
+                    _open = false;
+                } else {
+                    ::madvise(p, _size, MADV_SEQUENTIAL);
+                    _data = static_cast<const char*>(p);
+                }
+            }
+        }
+
+        // O mapeamento continua válido após fechar o descritor
+        ::close(fd);
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    // Desfaz o mapeamento
+    ~mapped_file() {
+        if (_data != nullptr) {
+            ::munmap(const_cast<char*>(_data), _size);
+        }
+    }
+
+    // Verifica se o arquivo foi aberto e mapeado com sucesso
+    bool is_open() const { return _open; }
+
+    // Retorna o início do conteúdo do arquivo
+    const char* data() const { return _data; }
+
+    // Retorna o tamanho do arquivo em bytes
+    size_t size() const { return _size; }
+};
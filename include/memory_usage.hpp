@@ -0,0 +1,68 @@
+#pragma once
+
+#include <unicode/unistr.h>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Memória usada por uma estrutura de dados, em bytes, separada por categoria.
+// Os valores são estimativas feitas a partir dos tamanhos dos objetos e das
+// capacidades reservadas; o cabeçalho que o malloc guarda em cada alocação
+// não é contado.
+struct memory_breakdown {
+    size_t nodes = 0;        // Nós ou entradas ocupadas
+    size_t key_heap = 0;     // Memória na heap das chaves e valores
+    size_t buckets = 0;      // Vetor de buckets, slots livres e controle
+    size_t sorted_keys = 0;  // Cópia ordenada das chaves (iteradores)
+    size_t slack = 0;        // Reservado pelo alocador e ainda não usado
+
+    // Retorna a soma de todas as categorias
+    size_t total() const {
+        return nodes + key_heap + buckets + sorted_keys + slack;
+    }
+};
+
+// Retorna a memória na heap usada por um objeto, além do próprio objeto. O
+// padrão é zero, para tipos que não alocam memória (int, por exemplo)
+template <typename T>
+size_t heap_bytes(const T&) {
+    return 0;
+}
+
+// Verifica se o buffer p está dentro do próprio objeto (strings curtas)
+template <typename T>
+bool inline_buffer(const T& object, const void* p) {
+    const char* begin = reinterpret_cast<const char*>(&object);
+    const char* c = static_cast<const char*>(p);
+    return c >= begin && c < begin + sizeof(T);
+}
+
+// Strings curtas ficam dentro do objeto (small string optimization)
+inline size_t heap_bytes(const std::string& s) {
+    return inline_buffer(s, s.data()) ? 0 : s.capacity() + 1;
+}
+
+// UnicodeStrings curtas ficam no buffer interno do objeto; as longas usam um
+// buffer na heap precedido por um contador de referências. Cópias de uma
+// UnicodeString podem compartilhar o mesmo buffer, então o valor de várias
+// cópias é um limite superior
+inline size_t heap_bytes(const icu::UnicodeString& s) {
+    const char16_t* buffer = s.getBuffer();
+    if (buffer == nullptr || inline_buffer(s, buffer)) {
+        return 0;
+    }
+    return s.getCapacity() * sizeof(char16_t) + sizeof(int32_t);
+}
+
+// Retorna a memória do vetor de chaves ordenadas das tabelas hash: os pares
+// reservados mais a memória na heap de cada chave e valor copiados
+template <typename key_t, typename value_t>
+size_t sorted_keys_bytes(const std::vector<std::pair<key_t, value_t>>& v) {
+    size_t bytes = v.capacity() * sizeof(std::pair<key_t, value_t>);
+    for (const auto& p : v) {
+        bytes += heap_bytes(p.first) + heap_bytes(p.second);
+    }
+    return bytes;
+}
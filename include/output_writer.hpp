@@ -0,0 +1,151 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unicode/utf16.h>
+#include <unicode/utf8.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+
+// Retorna o número de bytes do texto em UTF-16 codificado em UTF-8 pelo
+// buffered_writer::write_utf16 (surrogates sem par ocupam 3 bytes, como
+// U+FFFD)
+inline size_t utf8_length(const char16_t* text, int32_t length) {
+    size_t bytes = 0;
+    int32_t i = 0;
+    while (i < length) {
+        UChar32 c;
+        U16_NEXT(text, i, length, c);
+        bytes += U_IS_SURROGATE(c) ? 3 : U8_LENGTH(c);
+    }
+    return bytes;
+}
+
+// Escritor de arquivo com um buffer de tamanho fixo. O conteúdo é codificado
+// diretamente no buffer (palavras em UTF-8, números com to_chars) e o buffer
+// é esvaziado com chamadas grandes a write(), então a memória usada não
+// depende do tamanho da saída.
+class buffered_writer {
+   private:
+    static constexpr size_t buffer_size = 256 * 1024;  // Bytes do buffer
+
+    int _fd;                          // Descritor do arquivo (-1 se fechado)
+    std::unique_ptr<char[]> _buffer;  // Buffer de saída
+    size_t _used;                     // Bytes ocupados no buffer
+    bool _failed;                     // Indica se alguma escrita falhou
+
+    // Escreve n bytes no arquivo, repetindo write() até escrever tudo
+    void _write_all(const char* data, size_t n) {
+        while (n > 0 && !_failed) {
+            ssize_t written = ::write(_fd, data, n);
+            if (written < 0) {
+                if (errno != EINTR) {
+                    _failed = true;
+                }
+                continue;
+            }
+            data += written;
+            n -= written;
+        }
+    }
+
+    // Garante que há pelo menos n bytes livres no buffer (n <= buffer_size)
+    void _reserve(size_t n) {
+        if (buffer_size - _used < n) {
+            flush();
+        }
+    }
+
+   public:
+    // Abre (ou cria) o arquivo para escrita, descartando o conteúdo anterior
+    explicit buffered_writer(const std::string& path)
+        : _fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)),
+          _buffer(new char[buffer_size]),
+          _used(0),
+          _failed(false) {}
+
+    buffered_writer(const buffered_writer&) = delete;
+    buffered_writer& operator=(const buffered_writer&) = delete;
+
+    // Destrutor (esvazia o buffer e fecha o arquivo)
+    ~buffered_writer() { close(); }
+
+    // Verifica se o arquivo foi aberto com sucesso
+    bool is_open() const { return _fd >= 0; }
+
+    // Escreve n bytes. Blocos maiores que o buffer são escritos diretamente
+    void write(const char* data, size_t n) {
+        if (n > buffer_size - _used) {
+            flush();
+            if (n >= buffer_size) {
+                _write_all(data, n);
+                return;
+            }
+        }
+        std::memcpy(_buffer.get() + _used, data, n);
+        _used += n;
+    }
+
+    void write(const std::string& text) { write(text.data(), text.size()); }
+
+    void write(char c) {
+        _reserve(1);
+        _buffer[_used++] = c;
+    }
+
+    // Escreve um número inteiro em decimal
+    void write(long long number) {
+        _reserve(24);
+        char* begin = _buffer.get() + _used;
+        _used = std::to_chars(begin, begin + 24, number).ptr - _buffer.get();
+    }
+
+    // Escreve um texto em UTF-16 codificado em UTF-8. Surrogates sem par são
+    // trocados por U+FFFD, como em UnicodeString::toUTF8String
+    void write_utf16(const char16_t* text, int32_t length) {
+        int32_t i = 0;
+        while (i < length) {
+            _reserve(4);
+            char* out = _buffer.get();
+
+            // Caminho rápido para caracteres ASCII
+            if (text[i] < 0x80) {
+                out[_used++] = static_cast<char>(text[i++]);
+                continue;
+            }
+
+            UChar32 c;
+            U16_NEXT(text, i, length, c);
+            if (U_IS_SURROGATE(c)) {
+                c = 0xFFFD;
+            }
+            U8_APPEND_UNSAFE(out, _used, c);
+        }
+    }
+
+    // Escreve no arquivo o conteúdo do buffer
+    void flush() {
+        if (_used > 0 && is_open()) {
+            _write_all(_buffer.get(), _used);
+        }
+        _used = 0;
+    }
+
+    // Esvazia o buffer e fecha o arquivo, retornando false se alguma escrita
+    // falhou
+    bool close() {
+        if (is_open()) {
+            flush();
+            if (::close(_fd) != 0) {
+                _failed = true;
+            }
+            _fd = -1;
+        }
+        return !_failed;
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <time.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Tempo gasto em uma etapa do processamento
+struct phase_time {
+    std::string name;  // Nome da etapa
+    double wall_ms;    // Tempo real em milissegundos
+    double cpu_ms;     // Tempo de CPU do processo (todas as threads)
+};
+
+// Mede o tempo real e o tempo de CPU de cada etapa do processamento, na ordem
+// em que as etapas são executadas. O tempo de CPU é o do processo inteiro,
+// então com várias threads ele pode ser maior que o tempo real.
+class phase_timer {
+   private:
+    std::vector<phase_time> _phases;  // Etapas já medidas
+    std::string _current;             // Etapa em andamento
+    std::chrono::steady_clock::time_point _wall_start;
+    double _cpu_start = 0;
+
+    // Tempo de CPU consumido pelo processo até agora, em milissegundos
+    static double cpu_now_ms() {
+        timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+    }
+
+    // Formata um tempo em milissegundos com três casas decimais
+    static std::string format_ms(double ms) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.3f", ms);
+        return buffer;
+    }
+
+   public:
+    // Inicia a medição de uma etapa
+    void start(const std::string& name) {
+        _current = name;
+        _cpu_start = cpu_now_ms();
+        _wall_start = std::chrono::steady_clock::now();
+    }
+
+    // Finaliza a medição da etapa em andamento
+    void stop() {
+        auto wall_stop = std::chrono::steady_clock::now();
+        double cpu_stop = cpu_now_ms();
+        std::chrono::duration<double, std::milli> wall =
+            wall_stop - _wall_start;
+        _phases.push_back({_current, wall.count(), cpu_stop - _cpu_start});
+    }
+
+    // Mede a execução de f() como uma etapa
+    template <typename function>
+    void measure(const std::string& name, function f) {
+        start(name);
+        f();
+        stop();
+    }
+
+    // Retorna as etapas medidas
+    const std::vector<phase_time>& phases() const { return _phases; }
+
+    // Retorna a soma dos tempos reais das etapas
+    double total_wall_ms() const {
+        double total = 0;
+        for (const auto& p : _phases) {
+            total += p.wall_ms;
+        }
+        return total;
+    }
+
+    // Retorna a soma dos tempos de CPU das etapas
+    double total_cpu_ms() const {
+        double total = 0;
+        for (const auto& p : _phases) {
+            total += p.cpu_ms;
+        }
+        return total;
+    }
+
+    // Retorna um relatório em texto, uma linha por etapa
+    std::string report() const {
+        std::string text = "Tempos por etapa (real / CPU):\n";
+        for (const auto& p : _phases) {
+            text += "  " + p.name + ": " + format_ms(p.wall_ms) + " ms / " +
+                    format_ms(p.cpu_ms) + " ms\n";
+        }
+        return text;
+    }
+
+    // Retorna as etapas em JSON, para leitura por outros programas
+    std::string to_json() const {
+        std::string json = "{\n  \"phases\": [\n";
+        for (size_t i = 0; i < _phases.size(); i++) {
+            const auto& p = _phases[i];
+            json += "    {\"phase\": \"" + p.name +
+                    "\", \"wall_ms\": " + format_ms(p.wall_ms) +
+                    ", \"cpu_ms\": " + format_ms(p.cpu_ms) + "}";
+            json += i + 1 < _phases.size() ? ",\n" : "\n";
+        }
+        json += "  ],\n  \"total_wall_ms\": " + format_ms(total_wall_ms()) +
+                ",\n  \"total_cpu_ms\": " + format_ms(total_cpu_ms()) + "\n}\n";
+        return json;
+    }
+};
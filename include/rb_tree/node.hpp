@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <utility>
 
 #define RED false
 #define BLACK true
@@ -13,7 +14,11 @@ struct rb_node {
     rb_node* right;                 // Ponteiro para o filho direito
     rb_node* parent;                // Ponteiro para o nó pai
 
-    rb_node(const key_t& k, const value_t& v, bool c = RED,
-            rb_node* l = nullptr, rb_node* r = nullptr, rb_node* p = nullptr)
-        : key(std::make_pair(k, v)), color(c), left(l), right(r), parent(p) {}
+    rb_node(key_t k, value_t v, bool c = RED, rb_node* l = nullptr,
+            rb_node* r = nullptr, rb_node* p = nullptr)
+        : key(std::move(k), std::move(v)),
+          color(c),
+          left(l),
+          right(r),
+          parent(p) {}
 };
\ No newline at end of file
@@ -3,50 +3,93 @@
 #include <iostream>
 #include <stack>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #define RED false
 #define BLACK true
 
+#include "../counting.hpp"
+#include "../memory_usage.hpp"
+#include "../slab_allocator.hpp"
+#include "../statistics.hpp"
 #include "node.hpp"
 
-template <typename key_t, typename value_t, typename compare = std::less<key_t>>
+// Árvore rubro-negra. A política allocator define de onde os nós são
+// alocados (slab_allocator por padrão, ou heap_allocator para um new por nó)
+// e a política counting define se as operações são contadas
+template <typename key_t, typename value_t, typename compare = std::less<key_t>,
+          typename allocator = slab_allocator,
+          typename counting = default_counting_policy>
 class red_black_tree {
    private:
+    using node_pool =
+        typename allocator::template pool<rb_node<key_t, value_t>>;
+
     rb_node<key_t, value_t>* _root;  // Raiz da árvore
     rb_node<key_t, value_t>* _nil;   // Nó sentinela que representa nulo (nil)
     unsigned int _size = 0;          // Número de elementos na árvore
     compare _compare;                // Functor de comparação
-    unsigned int _comparisons = 0;   // Número de comparações feitas
+    counting _counters;              // Contadores de operações
+    node_pool _pool;                 // Pool de onde os nós são alocados
+
+    // Compara duas chaves com o functor de comparação, contando a comparação
+    bool _less(const key_t& a, const key_t& b) {
+        _counters.comparison();
+        return _compare(a, b);
+    }
 
+    // Destrói os nós da subárvore de n. Se o pool libera a memória de uma vez,
+    // apenas os destrutores são chamados aqui
     void _clear(rb_node<key_t, value_t>* n) {
         if (n != _nil) {
             _clear(n->left);
             _clear(n->right);
-            delete n;
+            if constexpr (node_pool::bulk_release) {
+                n->~rb_node();
+            } else {
+                _pool.destroy(n);
+            }
+        }
+    }
+
+    // Destrói todos os nós da árvore e libera a memória do pool. Nós com
+    // chave e valor triviais nem precisam ser percorridos
+    void _release() {
+        if constexpr (!node_pool::bulk_release ||
+                      !std::is_trivially_destructible<
+                          rb_node<key_t, value_t>>::value) {
+            _clear(_root);
+        }
+        _pool.release();
+    }
+
+    // Muda a cor do nó n, contando a troca caso a cor seja diferente
+    void _set_color(rb_node<key_t, value_t>* n, bool color) {
+        if (n->color != color) {
+            _counters.recolor();
         }
+        n->color = color;
     }
 
     void _left_rotate(rb_node<key_t, value_t>* x) {
+        _counters.rotation();
+
         // Salva o nó y (filho direito de x)
         rb_node<key_t, value_t>* y = x->right;
 
-        _comparisons++;
         x->right = y->left;  // Atualiza o pai do filho esquerdo de y
         if (y->left != _nil) {
             y->left->parent = x;  // Atualiza o pai do filho esquerdo de y
         }
 
-        _comparisons++;
         y->parent = x->parent;  // Atualiza o pai de y para o pai de x
         if (x->parent == _nil) {
             _root = y;  // Se x era a raiz, y se torna a nova raiz
         } else if (x == x->parent->left) {
-            _comparisons++;
             x->parent->left = y;  // Atualiza o filho esquerdo do pai de x
         } else {
-            _comparisons++;
             x->parent->right = y;  // Atualiza o filho direito do pai de x
         }
 
@@ -56,24 +99,22 @@ class red_black_tree {
     }
 
     void _right_rotate(rb_node<key_t, value_t>* x) {
+        _counters.rotation();
+
         // Salva o nó y (filho esquerdo de x)
         rb_node<key_t, value_t>* y = x->left;
 
-        _comparisons++;
         x->left = y->right;  // Atualiza o pai do filho direito de y
         if (y->right != _nil) {
             y->right->parent = x;  // Atualiza o pai do filho direito de y
         }
 
-        _comparisons++;
         y->parent = x->parent;  // Atualiza o pai de y para o pai de x
         if (x->parent == _nil) {
             _root = y;  // Se x era a raiz, y se torna a nova raiz
         } else if (x == x->parent->left) {
-            _comparisons++;
             x->parent->left = y;  // Atualiza o filho esquerdo do pai de x
         } else {
-            _comparisons++;
             x->parent->right = y;  // Atualiza o filho direito do pai de x
         }
 
@@ -85,71 +126,61 @@ class red_black_tree {
     // Corrige a árvore após a inserção de um nó para manter as propriedades da
     // árvore rubro-negra
     void _insert_fixup(rb_node<key_t, value_t>* z) {
-        _comparisons++;
         while (z->parent->color == RED) {
-            _comparisons++;
             if (z->parent == z->parent->parent->left) {
                 rb_node<key_t, value_t>* y =
                     z->parent->parent->right;  // Tio de z
-                _comparisons++;
                 if (y->color == RED) {
                     // Caso 1: O tio de z é vermelho
-                    z->parent->color = BLACK;
-                    y->color = BLACK;
-                    z->parent->parent->color = RED;
+                    _set_color(z->parent, BLACK);
+                    _set_color(y, BLACK);
+                    _set_color(z->parent->parent, RED);
                     z = z->parent->parent;  // Move z para o avô
                 } else {
-                    _comparisons++;
                     if (z == z->parent->right) {
                         // Caso 2: z é filho direito
                         z = z->parent;
                         _left_rotate(z);  // Rotaciona á esquerda
                     }
                     // Caso 3: z é filho esquerdo
-                    z->parent->color = BLACK;
-                    z->parent->parent->color = RED;
+                    _set_color(z->parent, BLACK);
+                    _set_color(z->parent->parent, RED);
                     _right_rotate(z->parent->parent);
                 }
             } else {
                 rb_node<key_t, value_t>* y =
                     z->parent->parent->left;  // Tio de z
-                _comparisons++;
                 if (y->color == RED) {
                     // Caso 1: O tio de z é vermelho
-                    z->parent->color = BLACK;
-                    y->color = BLACK;
-                    z->parent->parent->color = RED;
+                    _set_color(z->parent, BLACK);
+                    _set_color(y, BLACK);
+                    _set_color(z->parent->parent, RED);
                     z = z->parent->parent;  // Move z para o avô
                 } else {
-                    _comparisons++;
                     if (z == z->parent->left) {
                         // Caso 2: z é filho esquerdo
                         z = z->parent;
                         _right_rotate(z);  // Rotaciona á direita
                     }
                     // Caso 3: z é filho direito
-                    z->parent->color = BLACK;
-                    z->parent->parent->color = RED;
+                    _set_color(z->parent, BLACK);
+                    _set_color(z->parent->parent, RED);
                     _left_rotate(z->parent->parent);
                 }
             }
-            _comparisons++;
         }
-        _comparisons++;
-        _root->color = BLACK;  // Garante que a raiz é preta
+        _set_color(_root, BLACK);  // Garante que a raiz é preta
     }
 
     // Remove o nó z da árvore e ajusta a árvore para manter suas propriedades
     void _remove(rb_node<key_t, value_t>* z) {
         rb_node<key_t, value_t>*y, *x;
-        _comparisons++;
         if (z->left == _nil || z->right == _nil) {
             y = z;  // Caso em que z tem no máximo um filho
         } else {
             y = _minimum(z->right);  // Caso em que z tem dois filhos
         }
 
-        _comparisons++;
         // Define x como o filho de y
         if (y->left != _nil) {
             x = y->left;
@@ -159,213 +190,253 @@ class red_black_tree {
 
         // Atualiza o pai de x
         x->parent = y->parent;
-        _comparisons++;
         if (y->parent == _nil) {
             _root = x;  // Caso em que y é a raiz
         } else if (y == y->parent->left) {
-            _comparisons++;
             y->parent->left = x;  // Atualiza o filho esquerdo do pai de y
         } else {
-            _comparisons++;
             y->parent->right = x;  // Atualiza o filho direito do pai de y
         }
 
-        _comparisons++;
         // Copia o valor de y para z se necessário
         if (y != z) {
-            z->key = y->key;
+            z->key = std::move(y->key);
         }
 
-        _comparisons++;
         // Se a cor de y é preta, ajusta a árvore
         if (y->color == BLACK) {
             _remove_fixup(x);
         }
 
-        delete y;  // Libera a memória do nó removido
+        _pool.destroy(y);  // Libera a memória do nó removido
     }
 
     // Corrige a árvore após a remoção de um nó para manter as propriedades da
     // árvore rubro-negra
     void _remove_fixup(rb_node<key_t, value_t>* x) {
         while (x != _root && x->color == BLACK) {
-            _comparisons++;
             if (x == x->parent->left) {
                 rb_node<key_t, value_t>* w = x->parent->right;  // Irmão de x
-                _comparisons++;
                 if (w->color == RED) {
                     // Caso 1: O irmão de x é vermelho
-                    w->color = BLACK;
-                    x->parent->color = RED;
+                    _set_color(w, BLACK);
+                    _set_color(x->parent, RED);
                     _left_rotate(x->parent);  // Rotaciona á esquerda
                     w = x->parent->right;     // Atualiza o irmão de x
                 }
-                _comparisons += 2;
                 if (w->left->color == BLACK && w->right->color == BLACK) {
                     // Caso 2: Ambos os filhos de w são pretos
-                    w->color = RED;  // Torna w vermelho
-                    x = x->parent;   // Move x para o pai
+                    _set_color(w, RED);  // Torna w vermelho
+                    x = x->parent;       // Move x para o pai
                 } else {
-                    _comparisons++;
                     if (w->right->color == BLACK) {
                         // Caso 3: O filho direito de w é preto
-                        w->left->color = BLACK;
-                        w->color = RED;
+                        _set_color(w->left, BLACK);
+                        _set_color(w, RED);
                         _right_rotate(w);      // Rotaciona w para a direita
                         w = x->parent->right;  // Atualliza w
                     }
                     // Caso 4: O filho direito de w é vermelho
-                    w->color = x->parent->color;
-                    x->parent->color = BLACK;
-                    w->right->color = BLACK;
+                    _set_color(w, x->parent->color);
+                    _set_color(x->parent, BLACK);
+                    _set_color(w->right, BLACK);
                     _left_rotate(x->parent);  // Rotaciona á esquerda
                     x = _root;                // Move x para a raiz
                 }
             } else {
                 rb_node<key_t, value_t>* w = x->parent->left;  // Irmão de x
-                _comparisons++;
                 if (w->color == RED) {
                     // Caso 1: O irmão de x é vermelho
-                    w->color = BLACK;
-                    x->parent->color = RED;
+                    _set_color(w, BLACK);
+                    _set_color(x->parent, RED);
                     _right_rotate(x->parent);  // Rotaciona á direita
                     w = x->parent->left;       // Atualiza w
                 }
-                _comparisons += 2;
                 if (w->right->color == BLACK && w->left->color == BLACK) {
                     // Caso 2: Ambos os filhos de w são pretos
-                    w->color = RED;  // Torna w vermelho
-                    x = x->parent;   // Move x para o pai
+                    _set_color(w, RED);  // Torna w vermelho
+                    x = x->parent;       // Move x para o pai
                 } else {
-                    _comparisons++;
                     if (w->left->color == BLACK) {
                         // Caso 3: O filho esquerdo de w é preto
-                        w->right->color = BLACK;
-                        w->color = RED;
+                        _set_color(w->right, BLACK);
+                        _set_color(w, RED);
                         _left_rotate(w);      // Rotaciona w para a esquerda
                         w = x->parent->left;  // Atualiza w
                     }
                     // Caso 4: O filho esquerdo de w é vermelho
-                    w->color = x->parent->color;
-                    x->parent->color = BLACK;
-                    w->left->color = BLACK;
+                    _set_color(w, x->parent->color);
+                    _set_color(x->parent, BLACK);
+                    _set_color(w->left, BLACK);
                     _right_rotate(x->parent);  // Rotaciona á direita
                     x = _root;                 // Move x para a raiz
                 }
             }
         }
-        _comparisons++;
-        x->color = BLACK;  // Garante que a raiz é preta
+        _set_color(x, BLACK);  // Garante que a raiz é preta
     }
 
     // Encontra o nó com a menor chave na subárvore com raiz em x
     rb_node<key_t, value_t>* _minimum(rb_node<key_t, value_t>* x) {
-        _comparisons++;
         while (x->left != _nil) {
             x = x->left;  // Desce para o filho esquerdo
-            _comparisons++;
         }
-        _comparisons++;
         return x;  // x é o nó com a menor chave
     }
 
     // Encontra o nó com a maior chave na subárvore com raiz em x
     rb_node<key_t, value_t>* _maximum(rb_node<key_t, value_t>* x) {
-        _comparisons++;
         while (x->right != _nil) {
             x = x->right;  // Desce para o filho direito
-            _comparisons++;
         }
-        _comparisons++;
         return x;  // x é o nó com a maior chave
     }
 
     rb_node<key_t, value_t>* _search(rb_node<key_t, value_t>* n,
                                      const key_t& k) {
-        _comparisons++;
-        while (n != _nil && k != n->key.first) {
-            _comparisons += 2;
-            if (_compare(k, n->key.first)) {
+        while (n != _nil) {
+            if (_less(k, n->key.first)) {
                 n = n->left;
-            } else {
+            } else if (_less(n->key.first, k)) {
                 n = n->right;
+            } else {
+                break;  // Chave encontrada
             }
         }
-        _comparisons++;
         return n;
     }
 
-   public:
-    // Contrutor que inicializa a árvore com um nó sentinela _nil
-    red_black_tree()
-        : _root(nullptr),
-          _nil(new rb_node<key_t, value_t>(key_t(), value_t(), BLACK)) {
-        _root = _nil;
+    // Percorre a subárvore de n em ordem, chamando f(chave, valor)
+    template <typename function>
+    void _for_each(rb_node<key_t, value_t>* n, function& f) const {
+        if (n != _nil) {
+            _for_each(n->left, f);
+            f(n->key.first, n->key.second);
+            _for_each(n->right, f);
+        }
     }
 
-    // Destrutor que libera a memória alocada para os nós da árvore
-    ~red_black_tree() {
-        _clear(_root);
-        delete _nil;
+    // Registra no histograma h a profundidade de cada nó da subárvore de n
+    void _depths(rb_node<key_t, value_t>* n, size_t depth,
+                 histogram& h) const {
+        if (n != _nil) {
+            h.add(depth);
+            _depths(n->left, depth + 1, h);
+            _depths(n->right, depth + 1, h);
+        }
     }
 
-    // Insere um novo valor na árvore
-    void insert(const key_t& k, const value_t& v) {
+    // Insere a chave k (caso não exista) e retorna o nó que contém a chave,
+    // seja ele o nó recém-criado ou o nó já existente. A chave e o valor só
+    // são copiados (ou movidos, conforme os argumentos) para o novo nó
+    template <typename key_arg, typename value_arg>
+    rb_node<key_t, value_t>* _insert(key_arg&& k, value_arg&& v) {
         rb_node<key_t, value_t>* current = _root;
         rb_node<key_t, value_t>* current_parent = _nil;
+        bool left = false;  // Indica se o novo nó será filho esquerdo
 
         // Encontra o local correto para inserir o novo nó'
-        _comparisons++;
         while (current != _nil) {
             current_parent = current;
-            _comparisons++;
-            if (_compare(k, current->key.first)) {
+            left = _less(k, current->key.first);
+            if (left) {
                 current = current->left;
-            } else if (_compare(current->key.first, k)) {
-                _comparisons++;
+            } else if (_less(current->key.first, k)) {
                 current = current->right;
             } else {
-                _comparisons++;
-                return;
+                return current;  // A chave já existe
             }
-            _comparisons++;
         }
 
         // Cria o novo nó e define seu pai
         rb_node<key_t, value_t>* new_node =
-            new rb_node<key_t, value_t>(k, v, RED, _nil, _nil, current_parent);
+            _pool.create(std::forward<key_arg>(k), std::forward<value_arg>(v),
+                         RED, _nil, _nil, current_parent);
 
-        _comparisons++;
         if (current_parent == _nil) {
             _root = new_node;  // A árvore estava vazia
-        } else if (_compare(k, current_parent->key.first)) {
-            _comparisons++;
+        } else if (left) {
             current_parent->left = new_node;  // Insere como filho esquerdo
         } else {
-            _comparisons++;
             current_parent->right = new_node;  // Insere como filho direito
         }
 
         _size++;  // Incrementa o tamanho da árvore
 
         // Corrige a árvore para manter as propriedades da árvore rubro-negra
+        // (as rotações não movem as chaves entre os nós)
         _insert_fixup(new_node);
+        return new_node;
     }
 
-    // Remove um valor da árvore
-    void remove(const key_t& k) {
-        rb_node<key_t, value_t>* p = _root;
-        _comparisons++;
-        while (p != _nil && k != p->key.first) {
-            _comparisons += 2;
-            if (_compare(k, p->key.first)) {
-                p = p->left;
-            } else {
-                p = p->right;
-            }
+    // Monta uma subárvore balanceada com os pares [first, last), já em ordem
+    // crescente, com o par do meio na raiz. Os níveis acima de red_depth
+    // ficam completos, então pintar de vermelho apenas os nós do último
+    // nível (incompleto) mantém o mesmo número de nós pretos em todo caminho
+    template <typename iterator_t>
+    rb_node<key_t, value_t>* _build(iterator_t first, iterator_t last,
+                                    rb_node<key_t, value_t>* parent,
+                                    size_t depth, size_t red_depth) {
+        if (first == last) {
+            return _nil;
         }
+        iterator_t middle = first + (last - first) / 2;
+        rb_node<key_t, value_t>* n =
+            _pool.create(middle->first, middle->second,
+                         depth == red_depth ? RED : BLACK, _nil, _nil, parent);
+        n->left = _build(first, middle, n, depth + 1, red_depth);
+        n->right = _build(middle + 1, last, n, depth + 1, red_depth);
+        return n;
+    }
+
+   public:
+    using key_type = key_t;       // Tipo das chaves
+    using mapped_type = value_t;  // Tipo dos valores
+    using key_compare = compare;  // Ordem das chaves
+
+    // Contrutor que inicializa a árvore com um nó sentinela _nil
+    red_black_tree()
+        : _root(nullptr),
+          _nil(new rb_node<key_t, value_t>(key_t(), value_t(), BLACK)) {
+        _root = _nil;
+    }
+
+    // Destrutor que libera a memória alocada para os nós da árvore
+    ~red_black_tree() {
+        _release();
+        delete _nil;
+    }
+
+    // Insere um novo valor na árvore
+    void insert(const key_t& k, const value_t& v) { _insert(k, v); }
+
+    // Insere um novo valor na árvore, movendo a chave para o novo nó
+    void insert(key_t&& k, const value_t& v) { _insert(std::move(k), v); }
+
+    // Constrói o par (chave, valor) a partir de args e o insere na árvore,
+    // movendo a chave e o valor para o novo nó. Retorna se houve inserção
+    template <typename... args_t>
+    bool emplace(args_t&&... args) {
+        std::pair<key_t, value_t> p(std::forward<args_t>(args)...);
+        unsigned int old_size = _size;
+        _insert(std::move(p.first), std::move(p.second));
+        return _size != old_size;
+    }
+
+    // Retorna a referência para o valor associado a uma chave, inserindo a
+    // chave com o valor v caso ela não exista (uma única descida na árvore)
+    value_t& find_or_insert(const key_t& k, const value_t& v) {
+        return _insert(k, v)->key.second;
+    }
 
-        _comparisons++;
+    // Igual a find_or_insert, mas move a chave para o novo nó (se criado)
+    value_t& find_or_insert(key_t&& k, const value_t& v) {
+        return _insert(std::move(k), v)->key.second;
+    }
+
+    // Remove um valor da árvore
+    void remove(const key_t& k) {
+        rb_node<key_t, value_t>* p = _search(_root, k);
         if (p != _nil) {
             _remove(p);  // Remove o nó encontrado
             _size--;     // Decrementa o tamanho da árvore
@@ -374,11 +445,27 @@ class red_black_tree {
 
     // Limpa a árvore
     void clear() {
-        _clear(_root);
+        _release();
         _root = _nil;
         _size = 0;
     }
 
+    // Substitui o conteúdo da árvore pelos pares [first, last), que devem
+    // estar em ordem estritamente crescente de chave. A árvore é montada já
+    // balanceada em O(n), sem comparações nem rotações
+    template <typename iterator_t>
+    void assign_sorted(iterator_t first, iterator_t last) {
+        clear();
+        _size = static_cast<unsigned int>(last - first);
+
+        // Número de níveis completos: o maior h com 2^h - 1 <= _size
+        size_t red_depth = 0;
+        while ((size_t(2) << red_depth) - 1 <= _size) {
+            red_depth++;
+        }
+        _root = _build(first, last, _nil, 0, red_depth);
+    }
+
     // Retorna o tamanho da árvore
     unsigned int size() const { return _size; }
 
@@ -388,7 +475,6 @@ class red_black_tree {
     // Retorna a referência para o valor associado a uma chave
     value_t& search(const key_t& k) {
         rb_node<key_t, value_t>* node = _search(_root, k);
-        _comparisons++;
         if (node != _nil) {
             return node->key.second;
         }
@@ -396,13 +482,22 @@ class red_black_tree {
         throw std::out_of_range("Key not found");
     }
 
+    // Retorna um ponteiro para o valor associado a uma chave, ou nullptr caso a
+    // chave não exista
+    value_t* find(const key_t& k) {
+        rb_node<key_t, value_t>* n = _search(_root, k);
+        if (n != _nil) {
+            return &n->key.second;
+        }
+        return nullptr;
+    }
+
     // Verifica se a árvore contém a chave k
     bool contains(const key_t& k) { return _search(_root, k) != _nil; }
 
     // Atualiza o valor associado à chave k
     void att(const key_t& k, const value_t& v) {
         rb_node<key_t, value_t>* n = _search(_root, k);
-        _comparisons++;
         if (n == _nil) {
             return;
         }
@@ -411,6 +506,12 @@ class red_black_tree {
         return;
     }
 
+    // Percorre todos os pares da árvore em ordem, chamando f(chave, valor)
+    template <typename function>
+    void for_each(function f) const {
+        _for_each(_root, f);
+    }
+
     // Iterador para a árvore rubro-negra
     class iterator {
        private:
@@ -456,7 +557,7 @@ class red_black_tree {
     // Retorna um iterador para o início da árvore
     iterator begin() {
         rb_node<key_t, value_t>* n = _root;
-        while (n->left != _nil) {
+        while (n != _nil && n->left != _nil) {
             n = n->left;
         }
         return iterator(n, _nil);
@@ -465,6 +566,34 @@ class red_black_tree {
     // Retorna um iterador para o final da árvore
     iterator end() { return iterator(_nil, _nil); }
 
-    // Retorna o número de comparações feitas
-    unsigned int comparisons() const { return _comparisons; }
+    // Retorna os contadores de operações
+    const counting& counters() const { return _counters; }
+
+    // Retorna a memória usada pela árvore, separada por categoria
+    memory_breakdown memory_usage() const {
+        memory_breakdown usage;
+        // O sentinela _nil é alocado fora do pool e também é contado
+        usage.nodes = (_size + 1) * sizeof(rb_node<key_t, value_t>);
+        for_each([&usage](const key_t& k, const value_t& v) {
+            usage.key_heap += heap_bytes(k) + heap_bytes(v);
+        });
+        usage.slack =
+            _pool.reserved_bytes() - _size * sizeof(rb_node<key_t, value_t>);
+        return usage;
+    }
+
+    // Retorna as estatísticas de forma da árvore: o histograma da
+    // profundidade dos nós (a raiz tem profundidade 0) e, com a contagem
+    // habilitada, o número de rotações e de trocas de cor
+    structure_stats stats() const {
+        structure_stats s;
+        if constexpr (counting::enabled) {
+            s.values.push_back({"rotações", _counters.rotations});
+            s.values.push_back({"trocas de cor", _counters.recolors});
+        }
+        histogram depths;
+        _depths(_root, 0, depths);
+        s.histograms.push_back({"profundidade dos nós", depths});
+        return s;
+    }
 };
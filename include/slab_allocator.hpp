@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Pool de objetos do tipo T alocados em blocos (slabs) contíguos. Cada bloco
+// guarda block_size objetos, evitando uma chamada a new por elemento e
+// mantendo os elementos próximos na memória. Objetos destruídos voltam para
+// uma lista livre e são reutilizados pelas próximas alocações.
+template <typename T, size_t block_size = 256>
+class slab_pool {
+   private:
+    // Posição de um bloco: guarda um objeto ou, se estiver livre, o ponteiro
+    // para a próxima posição livre
+    union slot {
+        slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::vector<slot*> _blocks;  // Blocos alocados
+    slot* _free;                 // Lista de posições livres
+    size_t _used;                // Posições já entregues do último bloco
+
+    // Retorna uma posição livre, alocando um novo bloco se necessário
+    void* _allocate() {
+        if (_free != nullptr) {
+            slot* s = _free;
+            _free = s->next;
+            return s->storage;
+        }
+        if (_blocks.empty() || _used == block_size) {
+            _blocks.push_back(new slot[block_size]);
+            _used = 0;
+        }
+        return _blocks.back()[_used++].storage;
+    }
+
+   public:
+    // Indica que release() devolve a memória de todos os objetos de uma vez
+    static constexpr bool bulk_release = true;
+
+    // Construtor
+    slab_pool() : _blocks(), _free(nullptr), _used(0) {}
+
+    slab_pool(const slab_pool&) = delete;
+    slab_pool& operator=(const slab_pool&) = delete;
+
+    // Destrutor (não chama os destrutores dos objetos ainda vivos)
+    ~slab_pool() { release(); }
+
+    // Constrói um objeto T no pool com os argumentos dados
+    template <typename... args_t>
+    T* create(args_t&&... args) {
+        void* p = _allocate();
+        return new (p) T(std::forward<args_t>(args)...);
+    }
+
+    // Destrói o objeto p e devolve sua posição à lista livre
+    void destroy(T* p) {
+        p->~T();
+        slot* s = reinterpret_cast<slot*>(p);
+        s->next = _free;
+        _free = s;
+    }
+
+    // Libera todos os blocos de uma vez, sem chamar os destrutores dos
+    // objetos (quem usa o pool deve destruí-los antes, se necessário)
+    void release() {
+        for (slot* block : _blocks) {
+            delete[] block;
+        }
+        _blocks.clear();
+        _free = nullptr;
+        _used = 0;
+    }
+
+    // Retorna a memória reservada pelos blocos (ocupada ou não)
+    size_t reserved_bytes() const {
+        return _blocks.size() * block_size * sizeof(slot) +
+               _blocks.capacity() * sizeof(slot*);
+    }
+};
+
+// "Pool" que aloca cada objeto individualmente com new e delete
+template <typename T>
+class heap_pool {
+   private:
+    size_t _live = 0;  // Objetos alocados e ainda não destruídos
+
+   public:
+    // A memória de cada objeto é devolvida em destroy(), não em release()
+    static constexpr bool bulk_release = false;
+
+    // Constrói um objeto T na heap com os argumentos dados
+    template <typename... args_t>
+    T* create(args_t&&... args) {
+        T* p = new T(std::forward<args_t>(args)...);
+        _live++;
+        return p;
+    }
+
+    // Destrói o objeto p e libera sua memória
+    void destroy(T* p) {
+        delete p;
+        _live--;
+    }
+
+    // Não há memória a liberar além da já devolvida em destroy()
+    void release() {}
+
+    // Retorna a memória dos objetos vivos
+    size_t reserved_bytes() const { return _live * sizeof(T); }
+};
+
+// Políticas de alocação de nós usadas como parâmetro de template pelas
+// árvores. Cada política define o pool usado para objetos do tipo T.
+
+// Aloca os nós em blocos contíguos, liberados todos de uma vez
+struct slab_allocator {
+    template <typename T>
+    using pool = slab_pool<T>;
+};
+
+// Aloca cada nó individualmente com new e delete
+struct heap_allocator {
+    template <typename T>
+    using pool = heap_pool<T>;
+};
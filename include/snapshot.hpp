@@ -0,0 +1,269 @@
+#pragma once
+
+#include <unicode/coll.h>
+#include <unicode/utf16.h>
+#include <unicode/utf8.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "output_writer.hpp"
+
+// Formato binário do snapshot de um dicionário. Os inteiros ficam na ordem de
+// bytes da máquina e cada seção começa em um múltiplo de 8 bytes, então o
+// arquivo mapeado pode ser lido diretamente, sem cópias:
+//   snapshot_header
+//   offsets: uint64_t[word_count + 1], início de cada palavra no blob (o
+//            último é o tamanho do blob)
+//   counts:  int32_t[word_count], frequência de cada palavra, seguida de
+//            bytes zero até um múltiplo de 8
+//   blob:    as palavras em UTF-8, concatenadas em ordem de colação
+// O cabeçalho identifica as regras de colação que ordenaram as palavras (o
+// locale do Collator e a sua versão), pois a ordem muda com o locale padrão
+// do processo e com a versão da ICU.
+struct snapshot_header {
+    char magic[8];                 // Identificador do formato ("DICTSNAP")
+    uint32_t version;              // Versão do formato
+    uint32_t reserved;             // Reservado (zero)
+    uint64_t word_count;           // Número de palavras
+    uint64_t blob_size;            // Tamanho do blob em bytes
+    char collation_locale[32];     // Locale das regras de colação
+    uint8_t collation_version[4];  // Versão do Collator (UCA e regras)
+    uint32_t padding;              // Completa o cabeçalho até 8 bytes (zero)
+};
+
+constexpr char snapshot_magic[8] = {'D', 'I', 'C', 'T', 'S', 'N', 'A', 'P'};
+constexpr uint32_t snapshot_version = 2;
+
+// Preenche no cabeçalho a identificação das regras de colação do collator.
+// Locales que usam as mesmas regras (como en_US e pt_BR, que usam as regras
+// raiz) têm a mesma identificação
+inline void set_collation(snapshot_header& header,
+                          const icu::Collator& collator) {
+    UErrorCode status = U_ZERO_ERROR;
+    icu::Locale locale = collator.getLocale(ULOC_ACTUAL_LOCALE, status);
+    std::memset(header.collation_locale, 0, sizeof(header.collation_locale));
+    std::strncpy(header.collation_locale,
+                 U_SUCCESS(status) ? locale.getName() : "",
+                 sizeof(header.collation_locale) - 1);
+    collator.getVersion(header.collation_version);
+}
+
+// Arredonda n para o próximo múltiplo de 8
+inline size_t snapshot_align(size_t n) { return (n + 7) & ~size_t(7); }
+
+// Escreve no arquivo o snapshot das palavras de container, que deve ser
+// percorrido com pares (palavra, frequência) na ordem de collator. O
+// container é percorrido duas vezes: a primeira calcula os offsets das
+// palavras no blob e a segunda escreve o blob. Retorna false se o arquivo não
+// pôde ser escrito
+template <typename container_t>
+bool write_snapshot(const std::string& filename, container_t& container,
+                    size_t word_count, const icu::Collator& collator) {
+    buffered_writer output(filename);
+    if (!output.is_open()) {
+        return false;
+    }
+
+    // Os offsets são calculados com o tamanho em UTF-8 de cada palavra
+    std::vector<uint64_t> offsets;
+    offsets.reserve(word_count + 1);
+    offsets.push_back(0);
+    for (const auto& pair : container) {
+        const icu::UnicodeString& word = pair.first;
+        offsets.push_back(offsets.back() +
+                          utf8_length(word.getBuffer(), word.length()));
+    }
+
+    snapshot_header header = {};
+    std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version = snapshot_version;
+    header.word_count = offsets.size() - 1;
+    header.blob_size = offsets.back();
+    set_collation(header, collator);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(offsets.data()),
+                 offsets.size() * sizeof(uint64_t));
+
+    // As frequências são escritas em blocos, sem montar o vetor inteiro
+    int32_t counts[1024];
+    size_t n = 0;
+    for (const auto& pair : container) {
+        counts[n++] = static_cast<int32_t>(pair.second);
+        if (n == 1024) {
+            output.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+            n = 0;
+        }
+    }
+    output.write(reinterpret_cast<const char*>(counts), n * sizeof(int32_t));
+    size_t counts_size = header.word_count * sizeof(int32_t);
+    for (size_t i = counts_size; i < snapshot_align(counts_size); i++) {
+        output.write('\0');
+    }
+
+    for (const auto& pair : container) {
+        const icu::UnicodeString& word = pair.first;
+        output.write_utf16(word.getBuffer(), word.length());
+    }
+    return output.close();
+}
+
+// Snapshot mapeado em memória para leitura. A estrutura do arquivo é validada
+// na abertura (identificador, versão, tamanhos das seções, offsets crescentes
+// e UTF-8 válido), então as palavras podem ser lidas sem novas verificações.
+// A ordem das palavras não é verificada palavra a palavra, pois exigiria
+// calcular a sort key de todas elas: ela só é usada se o snapshot foi
+// ordenado com as mesmas regras de colação (same_collation)
+class snapshot_view {
+   private:
+    mapped_file _file;         // Arquivo mapeado
+    snapshot_header _header;   // Cabeçalho (válido se o arquivo for válido)
+    std::string _error;        // Motivo da falha na validação (vazio se ok)
+    size_t _word_count;        // Número de palavras
+    const uint64_t* _offsets;  // Offsets das palavras no blob
+    const int32_t* _counts;    // Frequências das palavras
+    const char* _blob;         // Palavras em UTF-8
+
+    // Valida o arquivo mapeado, preenchendo os ponteiros das seções. Retorna
+    // a mensagem de erro, ou uma string vazia se o arquivo for válido
+    std::string _validate() {
+        if (!_file.is_open()) {
+            return "could not open file";
+        }
+
+        snapshot_header& header = _header;
+        if (_file.size() < sizeof(header)) {
+            return "file too small";
+        }
+        std::memcpy(&header, _file.data(), sizeof(header));
+        if (std::memcmp(header.magic, snapshot_magic, sizeof(header.magic)) !=
+            0) {
+            return "not a snapshot file";
+        }
+        if (header.version != snapshot_version) {
+            return "unsupported version " + std::to_string(header.version);
+        }
+
+        // Cada palavra ocupa pelo menos 13 bytes (offset, frequência e um
+        // byte no blob), o que limita word_count antes das multiplicações
+        size_t available = _file.size() - sizeof(header);
+        if (header.word_count > available / 13 ||
+            header.blob_size > available) {
+            return "section sizes exceed the file size";
+        }
+        size_t offsets_size = (header.word_count + 1) * sizeof(uint64_t);
+        size_t counts_size =
+            snapshot_align(header.word_count * sizeof(int32_t));
+        if (offsets_size + counts_size + header.blob_size != available) {
+            return "section sizes do not match the file size";
+        }
+
+        const char* data = _file.data() + sizeof(header);
+        _word_count = header.word_count;
+        _offsets = reinterpret_cast<const uint64_t*>(data);
+        _counts = reinterpret_cast<const int32_t*>(data + offsets_size);
+        _blob = data + offsets_size + counts_size;
+
+        // Offsets estritamente crescentes (sem palavras vazias), terminando
+        // no fim do blob
+        if (_offsets[0] != 0 || _offsets[_word_count] != header.blob_size) {
+            return "invalid word offsets";
+        }
+        for (size_t i = 0; i < _word_count; i++) {
+            if (_offsets[i] >= _offsets[i + 1]) {
+                return "invalid word offsets";
+            }
+        }
+
+        // O blob inteiro deve ser UTF-8 válido, sem caracteres cortados entre
+        // duas palavras
+        for (size_t i = 0; i < _word_count; i++) {
+            const uint8_t* word =
+                reinterpret_cast<const uint8_t*>(_blob + _offsets[i]);
+            int32_t length =
+                static_cast<int32_t>(_offsets[i + 1] - _offsets[i]);
+            int32_t j = 0;
+            while (j < length) {
+                UChar32 c;
+                U8_NEXT(word, j, length, c);
+                if (c < 0) {
+                    return "invalid UTF-8 in word " + std::to_string(i);
+                }
+            }
+        }
+        return "";
+    }
+
+   public:
+    // Abre, mapeia e valida o snapshot
+    explicit snapshot_view(const std::string& filename)
+        : _file(filename),
+          _header(),
+          _error(),
+          _word_count(0),
+          _offsets(nullptr),
+          _counts(nullptr),
+          _blob(nullptr) {
+        _error = _validate();
+        if (!_error.empty()) {
+            _word_count = 0;
+        }
+    }
+
+    snapshot_view(const snapshot_view&) = delete;
+    snapshot_view& operator=(const snapshot_view&) = delete;
+
+    // Verifica se o snapshot foi aberto e é válido
+    bool is_valid() const { return _error.empty(); }
+
+    // Retorna o motivo da falha na validação
+    const std::string& error() const { return _error; }
+
+    // Retorna o número de palavras
+    size_t size() const { return _word_count; }
+
+    // Verifica se as palavras foram ordenadas com as mesmas regras de
+    // colação do collator, ou seja, se estão na ordem de collator
+    bool same_collation(const icu::Collator& collator) const {
+        snapshot_header current = {};
+        set_collation(current, collator);
+        return std::memcmp(current.collation_locale, _header.collation_locale,
+                           sizeof(current.collation_locale)) == 0 &&
+               std::memcmp(current.collation_version,
+                           _header.collation_version,
+                           sizeof(current.collation_version)) == 0;
+    }
+
+    // Retorna a i-ésima palavra em UTF-8
+    std::string_view word(size_t i) const {
+        return std::string_view(_blob + _offsets[i],
+                                _offsets[i + 1] - _offsets[i]);
+    }
+
+    // Decodifica a i-ésima palavra para UTF-16 em out
+    void word_utf16(size_t i, std::u16string& out) const {
+        std::string_view utf8 = word(i);
+        const uint8_t* s = reinterpret_cast<const uint8_t*>(utf8.data());
+        int32_t length = static_cast<int32_t>(utf8.size());
+        out.clear();
+        int32_t j = 0;
+        while (j < length) {
+            UChar32 c;
+            U8_NEXT_UNSAFE(s, j, c);
+            if (U_IS_BMP(c)) {
+                out.push_back(static_cast<char16_t>(c));
+            } else {
+                out.push_back(U16_LEAD(c));
+                out.push_back(U16_TRAIL(c));
+            }
+        }
+    }
+
+    // Retorna a frequência da i-ésima palavra
+    int count(size_t i) const { return _counts[i]; }
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Histograma de valores inteiros não negativos: counts[v] é o número de
+// ocorrências do valor v
+struct histogram {
+    std::vector<size_t> counts;
+
+    // Registra uma ocorrência do valor value
+    void add(size_t value) {
+        if (value >= counts.size()) {
+            counts.resize(value + 1, 0);
+        }
+        counts[value]++;
+    }
+
+    // Retorna o número de ocorrências registradas
+    size_t total() const {
+        size_t total = 0;
+        for (size_t c : counts) {
+            total += c;
+        }
+        return total;
+    }
+
+    // Retorna a média dos valores registrados
+    double mean() const {
+        size_t sum = 0;
+        for (size_t v = 0; v < counts.size(); v++) {
+            sum += v * counts[v];
+        }
+        size_t n = total();
+        return n == 0 ? 0 : static_cast<double>(sum) / n;
+    }
+
+    // Retorna o menor valor v tal que pelo menos p% das ocorrências têm valor
+    // menor ou igual a v
+    size_t percentile(double p) const {
+        size_t n = total();
+        size_t seen = 0;
+        for (size_t v = 0; v < counts.size(); v++) {
+            seen += counts[v];
+            if (seen * 100.0 >= p * n) {
+                return v;
+            }
+        }
+        return 0;
+    }
+
+    // Retorna o maior valor registrado
+    size_t largest() const { return counts.empty() ? 0 : counts.size() - 1; }
+};
+
+// Estatísticas de distribuição de uma estrutura de dados: histogramas (tamanho
+// das sondagens, dos buckets, profundidade dos nós) e contadores, cada um
+// identificado por um nome
+struct structure_stats {
+    std::vector<std::pair<std::string, histogram>> histograms;
+    std::vector<std::pair<std::string, uint64_t>> values;
+
+    // Retorna um relatório em texto com os contadores e, para cada
+    // histograma, o resumo (média, percentis e máximo) e as contagens
+    std::string report() const {
+        std::string text = "Estatísticas da estrutura:\n";
+        for (const auto& v : values) {
+            text += "  " + v.first + ": " + std::to_string(v.second) + "\n";
+        }
+        for (const auto& h : histograms) {
+            char summary[128];
+            std::snprintf(summary, sizeof(summary),
+                          "média %.2f, p50 %zu, p99 %zu, máximo %zu",
+                          h.second.mean(), h.second.percentile(50),
+                          h.second.percentile(99), h.second.largest());
+            text += "  " + h.first + " (" + summary + "):\n";
+            for (size_t v = 0; v < h.second.counts.size(); v++) {
+                if (h.second.counts[v] != 0) {
+                    text += "    " + std::to_string(v) + ": " +
+                            std::to_string(h.second.counts[v]) + "\n";
+                }
+            }
+        }
+        return text;
+    }
+};
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <unicode/uchar.h>
+#include <unicode/unistr.h>
+#include <unicode/utf8.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Tokenizador que percorre o texto em UTF-8 uma única vez, separando as
+// palavras e convertendo-as para minúsculas. São consideradas parte de uma
+// palavra apenas as letras e os hífens que estejam entre duas letras. As
+// palavras com caracteres não ASCII são convertidas inteiras, com o
+// mapeamento completo de caixa da ICU (que depende do contexto, como o sigma
+// final do grego, e pode mudar o tamanho da palavra, como "İ" -> "i̇"). O
+// texto pode ser entregue em pedaços (feed), inclusive com sequências UTF-8
+// divididas entre dois pedaços. Com SSE2, os blocos de 16 bytes que só têm
+// caracteres ASCII são convertidos para minúsculas e classificados de uma só
+// vez, sem chamar a ICU.
+class utf8_tokenizer {
+   private:
+    // Tamanho máximo, em bytes, de cada parte processada por _feed. Os
+    // índices das macros UTF-8 da ICU são int32_t
+    static constexpr size_t max_chunk = 1 << 20;
+
+    icu::UnicodeString _word;   // Palavra atual (buffer reutilizado)
+    bool _pending_hyphen;       // Hífen após uma letra, aguardando a próxima
+    bool _needs_lower;          // A palavra tem letras não ASCII em maiúsculas
+    uint8_t _carry[4];          // Sequência UTF-8 incompleta do pedaço anterior
+    int32_t _carry_length;      // Número de bytes em _carry
+
+    // Finaliza a palavra atual, entregando-a ao callback caso não seja vazia
+    template <typename callback>
+    void _flush(callback& emit) {
+        _pending_hyphen = false;  // Hífen sem letra depois vira espaço
+        if (!_word.isEmpty()) {
+            if (_needs_lower) {
+                _word.toLower();
+                _needs_lower = false;
+            }
+            emit(_word);
+            _word.remove();  // Limpa a palavra mantendo a capacidade
+        }
+    }
+
+    // Processa um caractere do texto (c < 0 indica uma sequência inválida)
+    template <typename callback>
+    void _process(UChar32 c, callback& emit) {
+        // Caminho rápido para caracteres ASCII
+        if (c >= 0 && c < 0x80) {
+            if (c >= 'A' && c <= 'Z') {
+                c += 'a' - 'A';
+            }
+            if (c >= 'a' && c <= 'z') {
+                _append_letter(c);
+            } else if (c == '-' && !_word.isEmpty() && !_pending_hyphen) {
+                _pending_hyphen = true;
+            } else {
+                _flush(emit);
+            }
+            return;
+        }
+
+        // Caracteres não ASCII são tratados pela ICU. A conversão para
+        // minúsculas fica para o fim da palavra, pois depende do contexto
+        if (c >= 0 && u_isalpha(c)) {
+            _needs_lower = _needs_lower || u_tolower(c) != c;
+            _append_letter(c);
+        } else {
+            _flush(emit);
+        }
+    }
+
+    // Adiciona uma letra à palavra atual, mantendo o hífen pendente
+    void _append_letter(UChar32 c) {
+        if (_pending_hyphen) {
+            _word.append(static_cast<char16_t>('-'));
+            _pending_hyphen = false;
+        }
+        _word.append(c);
+    }
+
+    // Adiciona n letras de uma vez à palavra atual, mantendo o hífen pendente
+    void _append_letters(const char16_t* letters, int32_t n) {
+        if (_pending_hyphen) {
+            _word.append(static_cast<char16_t>('-'));
+            _pending_hyphen = false;
+        }
+        _word.append(letters, n);
+    }
+
+#ifdef __SSE2__
+    // Processa um bloco de 16 bytes caso todos sejam ASCII, retornando false
+    // (sem processar nada) se houver algum byte não ASCII no bloco
+    template <typename callback>
+    bool _process_ascii_block(const uint8_t* p, callback& emit) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if (_mm_movemask_epi8(bytes) != 0) {
+            return false;
+        }
+
+        // Converte as maiúsculas para minúsculas (A-Z ganha o bit 0x20) e
+        // marca as letras (bytes ASCII são positivos, então a comparação com
+        // sinal funciona)
+        __m128i upper =
+            _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('A' - 1)),
+                          _mm_cmplt_epi8(bytes, _mm_set1_epi8('Z' + 1)));
+        __m128i lower =
+            _mm_or_si128(bytes, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+        __m128i letters =
+            _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                          _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+        uint32_t mask = _mm_movemask_epi8(letters);
+
+        // Expande os bytes para UTF-16
+        alignas(16) char16_t units[16];
+        __m128i zero = _mm_setzero_si128();
+        _mm_store_si128(reinterpret_cast<__m128i*>(units),
+                        _mm_unpacklo_epi8(lower, zero));
+        _mm_store_si128(reinterpret_cast<__m128i*>(units + 8),
+                        _mm_unpackhi_epi8(lower, zero));
+
+        // Sequências de letras são adicionadas de uma vez; os demais
+        // caracteres (hífens e separadores) seguem o caminho normal
+        int32_t pos = 0;
+        while (pos < 16) {
+            if (mask & (1u << pos)) {
+                int32_t run = __builtin_ctz(~mask >> pos);
+                _append_letters(units + pos, run);
+                pos += run;
+            } else {
+                _process(units[pos], emit);
+                pos++;
+            }
+        }
+        return true;
+    }
+#endif
+
+    // Processa uma parte do texto com no máximo max_chunk bytes
+    template <typename callback>
+    void _feed(const uint8_t* s, int32_t length, callback& emit) {
+        int32_t i = 0;
+
+        // Completa a sequência UTF-8 que ficou dividida no pedaço anterior
+        if (_carry_length > 0) {
+            int32_t needed = 1 + U8_COUNT_TRAIL_BYTES(_carry[0]);
+            while (_carry_length < needed && i < length &&
+                   U8_IS_TRAIL(s[i])) {
+                _carry[_carry_length++] = s[i++];
+            }
+            if (_carry_length < needed && i == length) {
+                return;  // O pedaço acabou antes de completar a sequência
+            }
+
+            int32_t j = 0;
+            UChar32 c;
+            U8_NEXT(_carry, j, _carry_length, c);
+            _process(c, emit);
+            _carry_length = 0;
+        }
+
+        // Sequências incompletas no final do pedaço são guardadas para o
+        // próximo pedaço
+        int32_t end = length;
+        for (int32_t back = 1; back <= 3 && back <= length - i; back++) {
+            uint8_t b = s[length - back];
+            if (!U8_IS_TRAIL(b)) {
+                if (U8_IS_LEAD(b) && 1 + U8_COUNT_TRAIL_BYTES(b) > back) {
+                    end = length - back;
+                }
+                break;
+            }
+        }
+
+        while (i < end) {
+#ifdef __SSE2__
+            // Blocos só com ASCII são processados de uma vez; nos demais, os
+            // caracteres do bloco seguem o caminho normal
+            if (end - i >= 16) {
+                if (_process_ascii_block(s + i, emit)) {
+                    i += 16;
+                    continue;
+                }
+                int32_t block_end = i + 16;
+                while (i < block_end) {
+                    UChar32 c;
+                    U8_NEXT(s, i, end, c);
+                    _process(c, emit);
+                }
+                continue;
+            }
+#endif
+            UChar32 c;
+            U8_NEXT(s, i, end, c);
+            _process(c, emit);
+        }
+
+        while (end < length) {
+            _carry[_carry_length++] = s[end++];
+        }
+    }
+
+   public:
+    // Construtor
+    utf8_tokenizer()
+        : _pending_hyphen(false), _needs_lower(false), _carry_length(0) {}
+
+    // Processa um pedaço do texto, chamando emit(const UnicodeString&) para
+    // cada palavra completa encontrada. Pedaços grandes (como um arquivo
+    // inteiro mapeado com mmap) são processados em partes de até max_chunk
+    // bytes; as sequências UTF-8 divididas entre duas partes são tratadas
+    // como entre dois pedaços
+    template <typename callback>
+    void feed(const char* data, size_t size, callback emit) {
+        const uint8_t* s = reinterpret_cast<const uint8_t*>(data);
+        while (size > 0) {
+            size_t length = std::min(size, max_chunk);
+            _feed(s, static_cast<int32_t>(length), emit);
+            s += length;
+            size -= length;
+        }
+    }
+
+    // Finaliza o texto, entregando a última palavra (se houver)
+    template <typename callback>
+    void finish(callback emit) {
+        if (_carry_length > 0) {
+            _carry_length = 0;
+            _flush(emit);  // Sequência incompleta no final do texto
+        }
+        _flush(emit);
+    }
+};
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/tokenizer.hpp"
+#include "benchmark_utils.cpp"
+#include "modes.cpp"
+#include "utils.cpp"
+
+using namespace std;
+
+// Benchmark de ponta a ponta: monta o dicionário de cada estrutura com cada
+// texto da pasta in (e com concatenações do texto repetido várias vezes),
+// medindo o tempo de inserção de todas as palavras. O texto é lido para a
+// memória antes da medição, então o tempo não inclui a leitura do arquivo.
+
+// Opções do benchmark passadas pela linha de comando
+struct benchmark_options {
+    unsigned int warmup = 1;            // Execuções descartadas
+    unsigned int repetitions = 5;       // Execuções medidas
+    vector<unsigned int> scales{1, 4};  // Fatores de repetição dos textos
+    vector<string> modes;               // Estruturas (vazio = todas)
+    vector<string> corpora;             // Textos (vazio = todos da pasta in)
+    string format = "csv";              // Formato da saída (csv ou json)
+    string output;                      // Arquivo de saída (vazio = stdout)
+};
+
+// Resultado das medições de uma estrutura com um texto
+struct benchmark_result {
+    string mode;          // Estrutura de dados
+    string corpus;        // Nome do texto
+    unsigned int scale;   // Número de repetições do texto
+    size_t bytes;         // Tamanho do texto em bytes
+    size_t words;         // Número de palavras do texto
+    size_t distinct;      // Número de palavras diferentes
+    long long min_ns;     // Menor tempo medido
+    long long median_ns;  // Mediana dos tempos
+    long long p99_ns;     // Percentil 99 dos tempos
+
+    // Palavras inseridas por segundo, considerando a mediana
+    double words_per_second() const {
+        return words * 1e9 / max(median_ns, 1LL);
+    }
+
+    // Megabytes processados por segundo, considerando a mediana
+    double mb_per_second() const { return bytes * 1e3 / max(median_ns, 1LL); }
+};
+
+// Função para exibir o uso correto do benchmark
+void display_benchmark_usage(const char *program_name) {
+    cerr << "Uso: " << program_name << " [opções]" << endl;
+    cerr << "Opções:" << endl;
+    cerr << "  --warmup N       execuções descartadas antes das medições "
+            "(padrão 1)"
+         << endl;
+    cerr << "  --reps N         execuções medidas (padrão 5)" << endl;
+    cerr << "  --scales A,B,... repetições de cada texto (padrão 1,4)" << endl;
+    cerr << "  --mode M         mede apenas a estrutura M (pode repetir)"
+         << endl;
+    cerr << "  --corpus F       mede apenas o texto in/F (pode repetir)"
+         << endl;
+    cerr << "  --format F       formato da saída: csv ou json (padrão csv)"
+         << endl;
+    cerr << "  --output F       escreve o resultado em F em vez da saída "
+            "padrão"
+         << endl;
+}
+
+// Lê as opções do benchmark, retornando false se alguma opção for inválida
+bool parse_benchmark_options(int argc, char *argv[],
+                             benchmark_options &options) {
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Error: Missing value for option " << option << endl;
+            return false;
+        }
+
+        string value = argv[++i];
+        bool valid = true;
+        if (option == "--warmup") {
+            // Zero execuções de aquecimento também é válido
+            valid = parse_number(value.c_str(), options.warmup, 0);
+        } else if (option == "--reps") {
+            valid = parse_number(value.c_str(), options.repetitions);
+        } else if (option == "--scales") {
+            options.scales.clear();
+            stringstream list(value);
+            string item;
+            while (valid && getline(list, item, ',')) {
+                unsigned int scale;
+                valid = parse_number(item.c_str(), scale);
+                options.scales.push_back(scale);
+            }
+            valid = valid && !options.scales.empty();
+        } else if (option == "--mode") {
+            valid = find(dictionary_modes.begin(), dictionary_modes.end(),
+                         value) != dictionary_modes.end();
+            options.modes.push_back(value);
+        } else if (option == "--corpus") {
+            options.corpora.push_back(value);
+        } else if (option == "--format") {
+            valid = value == "csv" || value == "json";
+            options.format = value;
+        } else if (option == "--output") {
+            options.output = value;
+        } else {
+            cerr << "Error: Invalid option " << option << endl;
+            return false;
+        }
+
+        if (!valid) {
+            cerr << "Error: Invalid value " << value << " for option "
+                 << option << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Conta as palavras de um texto com o mesmo tokenizador dos dicionários
+size_t count_words(const string &text) {
+    size_t words = 0;
+    utf8_tokenizer tokenizer;
+    auto emit = [&words](const UnicodeString &) { words++; };
+    tokenizer.feed(text.data(), text.size(), emit);
+    tokenizer.finish(emit);
+    return words;
+}
+
+// Mede a montagem do dicionário de uma estrutura com um texto
+benchmark_result run_benchmark(const string &mode, const string &corpus,
+                               unsigned int scale, const string &text,
+                               size_t words,
+                               const benchmark_options &options) {
+    vector<long long> times;
+    size_t distinct = 0;
+
+    for (unsigned int i = 0; i < options.warmup + options.repetitions; i++) {
+        with_dictionary(mode, [&](auto &dict) {
+            long long time = measure_ns(
+                [&] { dict.insert_utf8(text.data(), text.size()); });
+
+            // As execuções de aquecimento não entram no resultado
+            if (i >= options.warmup) {
+                times.push_back(time);
+            }
+            distinct = dict.size();
+        });
+    }
+
+    sort(times.begin(), times.end());
+    return benchmark_result{mode,
+                            corpus,
+                            scale,
+                            text.size(),
+                            words,
+                            distinct,
+                            times.front(),
+                            percentile(times, 50),
+                            percentile(times, 99)};
+}
+
+// Escreve os resultados em CSV, uma linha por estrutura, texto e escala
+void write_csv(ostream &out, const vector<benchmark_result> &results) {
+    out << fixed << setprecision(2);
+    out << "mode,corpus,scale,bytes,words,distinct,min_ns,median_ns,p99_ns,"
+           "words_per_s,mb_per_s\n";
+    for (const auto &r : results) {
+        out << r.mode << ',' << r.corpus << ',' << r.scale << ',' << r.bytes
+            << ',' << r.words << ',' << r.distinct << ',' << r.min_ns << ','
+            << r.median_ns << ',' << r.p99_ns << ',' << r.words_per_second()
+            << ',' << r.mb_per_second() << '\n';
+    }
+}
+
+// Escreve os resultados em JSON, como uma lista de objetos
+void write_json(ostream &out, const vector<benchmark_result> &results) {
+    out << fixed << setprecision(2);
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto &r = results[i];
+        out << "  {\"mode\": \"" << r.mode << "\", \"corpus\": \"" << r.corpus
+            << "\", \"scale\": " << r.scale << ", \"bytes\": " << r.bytes
+            << ", \"words\": " << r.words << ", \"distinct\": " << r.distinct
+            << ", \"min_ns\": " << r.min_ns
+            << ", \"median_ns\": " << r.median_ns
+            << ", \"p99_ns\": " << r.p99_ns
+            << ", \"words_per_s\": " << r.words_per_second()
+            << ", \"mb_per_s\": " << r.mb_per_second() << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+}
+
+int main(int argc, char *argv[]) {
+    benchmark_options options;
+    if (!parse_benchmark_options(argc, argv, options)) {
+        display_benchmark_usage(argv[0]);
+        return 1;
+    }
+
+    // Por padrão, mede todas as estruturas com todos os textos da pasta in
+    if (options.modes.empty()) {
+        options.modes = dictionary_modes;
+    }
+    if (options.corpora.empty()) {
+        for (const auto &entry : filesystem::directory_iterator("in")) {
+            if (entry.is_regular_file()) {
+                options.corpora.push_back(entry.path().filename().string());
+            }
+        }
+        sort(options.corpora.begin(), options.corpora.end());
+    }
+
+    vector<benchmark_result> results;
+    for (const string &corpus : options.corpora) {
+        string base = load_file("in/" + corpus);
+        size_t base_words = count_words(base);
+
+        for (unsigned int scale : options.scales) {
+            // Repete o texto, separando as cópias por uma quebra de linha para
+            // que a última palavra de uma cópia não se junte à primeira da
+            // próxima
+            string text;
+            text.reserve(scale * (base.size() + 1));
+            for (unsigned int i = 0; i < scale; i++) {
+                text += base;
+                text += '\n';
+            }
+
+            for (const string &mode : options.modes) {
+                cerr << mode << " " << corpus << " x" << scale << endl;
+                results.push_back(run_benchmark(mode, corpus, scale, text,
+                                                base_words * scale, options));
+            }
+        }
+    }
+
+    // Escreve o resultado no arquivo pedido ou na saída padrão
+    ofstream output_file;
+    if (!options.output.empty()) {
+        output_file.open(options.output);
+        if (!output_file.is_open()) {
+            cerr << "Error: Could not open file " << options.output << endl;
+            return 1;
+        }
+    }
+    ostream &out = options.output.empty() ? cout : output_file;
+
+    if (options.format == "json") {
+        write_json(out, results);
+    } else {
+        write_csv(out, results);
+    }
+    return 0;
+}
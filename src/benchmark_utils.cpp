@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Funções auxiliares compartilhadas pelos programas de benchmark
+
+// Converte o texto em um inteiro maior ou igual a minimum, retornando false
+// se o texto for inválido
+bool parse_number(const char *text, unsigned int &value, long minimum = 1) {
+    char *end;
+    long number = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || number < minimum) {
+        return false;
+    }
+    value = static_cast<unsigned int>(number);
+    return true;
+}
+
+// Lê o conteúdo inteiro de um arquivo
+std::string load_file(const std::string &file_path) {
+    std::ifstream input_file(file_path, std::ios::binary);
+    if (!input_file.is_open()) {
+        std::cerr << "Error: Could not open file " << file_path << std::endl;
+        std::exit(1);
+    }
+    return std::string((std::istreambuf_iterator<char>(input_file)),
+                       std::istreambuf_iterator<char>());
+}
+
+// Retorna o valor na posição do percentil p (0 a 100) de um vetor ordenado,
+// pelo método do posto mais próximo
+long long percentile(const std::vector<long long> &sorted, double p) {
+    size_t rank = static_cast<size_t>(p / 100.0 * sorted.size() + 0.999999);
+    rank = std::max<size_t>(1, std::min(rank, sorted.size()));
+    return sorted[rank - 1];
+}
+
+// Executa f() e retorna o tempo gasto em nanossegundos
+template <typename function>
+long long measure_ns(function f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+        .count();
+}
@@ -2,57 +2,42 @@
 #include <fstream>
 #include <iostream>
 
-#include "../include/avl_tree/avl_tree.hpp"
-#include "../include/compare.hpp"
-#include "../include/dictionary.hpp"
-#include "../include/hash_table/chained_hash_table.hpp"
-#include "../include/hash_table/open_hash_table.hpp"
-#include "../include/rb_tree/red_black_tree.hpp"
+#include "modes.cpp"
 #include "utils.cpp"
 
 using namespace std;
 
 int main(int argc, char* argv[]) {
     // Verifica se o número de argumentos está correto
-    if (argc != 3) {
+    if (argc < 2) {
         display_usage(argv[0]);
         return 1;
     }
 
-    // Salva o modo de estrutura e o nome do arquivo
+    // Salva o modo de estrutura e os nomes dos arquivos de entrada, que vêm
+    // antes das opções
     string mode_structure = argv[1];
-    string filename = argv[2];
-
-    // Dicionário utilizando uma árvore AVL
-    if (mode_structure == "dictionary_avl") {
-        dictionary<avl_tree<UnicodeString, int, unicode_compare>> dict;
-        process_and_save_dict(dict, filename, mode_structure);
-
-    }
-
-    // Dicionário utilizando uma árvore rubro-negra
-    else if (mode_structure == "dictionary_rb") {
-        dictionary<red_black_tree<UnicodeString, int, unicode_compare>> dict;
-        process_and_save_dict(dict, filename, mode_structure);
-
+    vector<string> filenames;
+    int first_option = 2;
+    while (first_option < argc &&
+           string(argv[first_option]).compare(0, 2, "--") != 0) {
+        filenames.push_back(argv[first_option++]);
     }
 
-    // Dicionário utilizando uma tabela hash com encadeamento exterior
-    else if (mode_structure == "dictionary_chained_hash") {
-        dictionary<chained_hash_table<UnicodeString, int, hash_unicode,
-                                      unicode_compare>>
-            dict;
-        process_and_save_dict(dict, filename, mode_structure);
-
-        // Dicionário utilizando tabela hash com endereçamento aberto
-    } else if (mode_structure == "dictionary_open_hash") {
-        dictionary<
-            open_hash_table<UnicodeString, int, hash_unicode, unicode_compare>>
-            dict;
-        process_and_save_dict(dict, filename, mode_structure);
+    // Lê as opções adicionais. É preciso ao menos um arquivo de entrada ou
+    // um snapshot
+    program_options options;
+    if (!parse_options(argc, argv, first_option, options) ||
+        (filenames.empty() && options.load_snapshots.empty())) {
+        display_usage(argv[0]);
+        return 1;
     }
 
-    else {
+    // Cria o dicionário com a estrutura escolhida, monta e salva
+    bool valid_mode = with_dictionary(mode_structure, [&](auto& dict) {
+        process_and_save_dict(dict, filenames, mode_structure, options);
+    });
+    if (!valid_mode) {
         cerr << "Error: Invalid mode of structure" << endl;
         display_usage(argv[0]);
         return 1;
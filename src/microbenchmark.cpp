@@ -0,0 +1,473 @@
+#include <unicode/coll.h>
+#include <unicode/unistr.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "benchmark_utils.cpp"
+#include "modes.cpp"
+#include "utils.cpp"
+
+using namespace std;
+
+// Microbenchmark das operações das estruturas de dados. Cada operação é medida
+// isoladamente (insert, search com acerto, find com falha, contains, att,
+// iteração, rehash e remove), com chaves UnicodeString (comparadas pela
+// collation, como no dicionário) e com chaves inteiras, em quatro ordens de
+// chaves. As medições de referência da collation e do hash isolados, junto com
+// as medições com chaves inteiras, indicam se uma regressão vem da collation,
+// do hash ou da própria estrutura.
+
+// Opções do microbenchmark passadas pela linha de comando
+struct micro_options {
+    unsigned int size = 50000;     // Número de chaves distintas
+    unsigned int repetitions = 5;  // Execuções medidas de cada operação
+    string format = "csv";         // Formato da saída (csv ou json)
+    string output;                 // Arquivo de saída (vazio = stdout)
+};
+
+// Resultado das medições de uma operação
+struct micro_result {
+    string structure;     // Estrutura de dados (ou baseline)
+    string key;           // Tipo da chave (unicode ou int)
+    string order;         // Ordem das chaves
+    string operation;     // Operação medida
+    size_t operations;    // Número de operações por execução
+    long long min_ns;     // Menor tempo medido
+    long long median_ns;  // Mediana dos tempos
+
+    // Tempo médio de uma operação, considerando a mediana
+    double ns_per_operation() const {
+        return static_cast<double>(median_ns) / max<size_t>(operations, 1);
+    }
+};
+
+// Chaves usadas nas medições de uma ordem
+template <typename key_t>
+struct key_set {
+    vector<key_t> sequence;  // Chaves na ordem das operações (com repetições)
+    vector<key_t> misses;    // Chaves que não estão na estrutura
+};
+
+// Verifica se a estrutura tem rehash (tabelas hash)
+template <typename T, typename = void>
+struct has_rehash : false_type {};
+
+template <typename T>
+struct has_rehash<T, void_t<decltype(declval<T &>().rehash(0))>>
+    : true_type {};
+
+// Gera count palavras distintas com letras minúsculas, incluindo letras
+// acentuadas, com o prefixo dado
+vector<UnicodeString> generate_words(size_t count, const UnicodeString &prefix,
+                                     mt19937_64 &rng) {
+    static const UnicodeString letters =
+        UnicodeString::fromUTF8("abcdefghijklmnopqrstuvwxyzáâãçéêíóôõú");
+    uniform_int_distribution<int> length(2, 12);
+    uniform_int_distribution<int> letter(0, letters.length() - 1);
+
+    set<UnicodeString> seen;
+    vector<UnicodeString> words;
+    while (words.size() < count) {
+        UnicodeString word = prefix;
+        for (int i = length(rng); i > 0; i--) {
+            word.append(letters.charAt(letter(rng)));
+        }
+        if (seen.insert(word).second) {
+            words.push_back(word);
+        }
+    }
+    return words;
+}
+
+// Gera count inteiros distintos; com high_bits, os valores diferem apenas nos
+// 32 bits mais altos (poucos bits de entropia para o hash)
+vector<int64_t> generate_integers(size_t count, bool high_bits,
+                                  mt19937_64 &rng) {
+    set<int64_t> seen;
+    vector<int64_t> values;
+    while (values.size() < count) {
+        int64_t value = static_cast<int64_t>(rng() >> 33);
+        if (high_bits) {
+            value = (value % (1LL << 30)) << 32;
+        }
+        if (seen.insert(value).second) {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+// Reordena as chaves (já ordenadas) alternando entre os extremos: a menor, a
+// maior, a segunda menor, a segunda maior e assim por diante
+template <typename key_t>
+vector<key_t> zigzag(const vector<key_t> &sorted) {
+    vector<key_t> result;
+    result.reserve(sorted.size());
+    size_t low = 0;
+    size_t high = sorted.size();
+    while (low < high) {
+        result.push_back(sorted[low++]);
+        if (low < high) {
+            result.push_back(sorted[--high]);
+        }
+    }
+    return result;
+}
+
+// Monta a sequência de operações de cada ordem a partir do universo de chaves
+// (universe) e de chaves ausentes (misses):
+// - uniform: todas as chaves em ordem aleatória
+// - zipfian: chaves sorteadas com distribuição de Zipf (s = 1), com repetições
+// - sorted: todas as chaves em ordem crescente
+// - adversarial: chaves de adversarial_universe (prefixo longo comum ou
+//   entropia apenas nos bits altos) alternando entre os extremos
+template <typename key_t, typename less_t>
+vector<pair<string, key_set<key_t>>> build_orders(
+    const vector<key_t> &universe, const vector<key_t> &misses,
+    const vector<key_t> &adversarial_universe,
+    const vector<key_t> &adversarial_misses, less_t less, mt19937_64 &rng) {
+    vector<pair<string, key_set<key_t>>> orders;
+
+    vector<key_t> uniform = universe;
+    shuffle(uniform.begin(), uniform.end(), rng);
+    orders.push_back({"uniform", {uniform, misses}});
+
+    vector<double> weights(universe.size());
+    for (size_t i = 0; i < weights.size(); i++) {
+        weights[i] = 1.0 / (i + 1);
+    }
+    discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+    vector<key_t> zipfian;
+    zipfian.reserve(universe.size());
+    for (size_t i = 0; i < universe.size(); i++) {
+        zipfian.push_back(uniform[zipf(rng)]);
+    }
+    orders.push_back({"zipfian", {zipfian, misses}});
+
+    vector<key_t> sorted = universe;
+    std::sort(sorted.begin(), sorted.end(), less);
+    orders.push_back({"sorted", {sorted, misses}});
+
+    vector<key_t> adversarial = adversarial_universe;
+    std::sort(adversarial.begin(), adversarial.end(), less);
+    orders.push_back(
+        {"adversarial", {zigzag(adversarial), adversarial_misses}});
+
+    return orders;
+}
+
+// Mede cada operação da estrutura container com as chaves de uma ordem. As
+// chaves são copiadas antes de cada operação (fora da medição) para que as
+// sort keys guardadas nas chaves não sejam reaproveitadas entre operações
+template <typename container, typename key_t>
+void bench_structure(const string &structure, const string &key_name,
+                     const string &order, const key_set<key_t> &keys,
+                     const micro_options &options,
+                     vector<micro_result> &results) {
+    const vector<string> operations = {"insert",   "search_hit", "find_miss",
+                                       "contains", "att",        "iterate",
+                                       "rehash",   "remove"};
+    vector<vector<long long>> times(operations.size());
+    vector<size_t> counts(operations.size(), keys.sequence.size());
+    counts[2] = keys.misses.size();
+
+    for (unsigned int rep = 0; rep < options.repetitions; rep++) {
+        unique_ptr<container> c(new container());
+        vector<key_t> probe;
+        long long checksum = 0;  // Evita que o compilador descarte as buscas
+
+        probe = keys.sequence;
+        times[0].push_back(measure_ns([&] {
+            for (const key_t &k : probe) {
+                c->insert(k, 1);
+            }
+        }));
+
+        probe = keys.sequence;
+        times[1].push_back(measure_ns([&] {
+            for (const key_t &k : probe) {
+                checksum += c->search(k);
+            }
+        }));
+
+        probe = keys.misses;
+        times[2].push_back(measure_ns([&] {
+            for (const key_t &k : probe) {
+                checksum += c->find(k) != nullptr;
+            }
+        }));
+
+        probe = keys.sequence;
+        times[3].push_back(measure_ns([&] {
+            for (const key_t &k : probe) {
+                checksum += c->contains(k);
+            }
+        }));
+
+        probe = keys.sequence;
+        times[4].push_back(measure_ns([&] {
+            for (const key_t &k : probe) {
+                c->att(k, 2);
+            }
+        }));
+
+        counts[5] = c->size();
+        times[5].push_back(measure_ns([&] {
+            for (const auto &p : *c) {
+                checksum += p.second;
+            }
+        }));
+
+        // Apenas as tabelas hash têm rehash
+        if constexpr (has_rehash<container>::value) {
+            counts[6] = c->size();
+            times[6].push_back(
+                measure_ns([&] { c->rehash(2 * c->bucket_count()); }));
+        }
+
+        probe = keys.sequence;
+        times[7].push_back(measure_ns([&] {
+            for (const key_t &k : probe) {
+                c->remove(k);
+            }
+        }));
+
+        if (checksum == 0) {
+            cerr << "Error: Unexpected empty structure" << endl;
+        }
+    }
+
+    for (size_t i = 0; i < operations.size(); i++) {
+        if (times[i].empty()) {
+            continue;
+        }
+        sort(times[i].begin(), times[i].end());
+        results.push_back(micro_result{structure, key_name, order,
+                                       operations[i], counts[i],
+                                       times[i].front(),
+                                       percentile(times[i], 50)});
+    }
+}
+
+// Mede todas as estruturas com um tipo de chave e uma ordem
+template <typename key_t, typename hash, typename compare>
+void bench_all_structures(const string &key_name, const string &order,
+                          const key_set<key_t> &keys,
+                          const micro_options &options,
+                          vector<micro_result> &results) {
+    cerr << key_name << " " << order << endl;
+    bench_structure<avl_tree<key_t, int, compare>>(
+        "avl_tree", key_name, order, keys, options, results);
+    bench_structure<red_black_tree<key_t, int, compare>>(
+        "red_black_tree", key_name, order, keys, options, results);
+    bench_structure<chained_hash_table<key_t, int, hash, compare>>(
+        "chained_hash_table", key_name, order, keys, options, results);
+    bench_structure<open_hash_table<key_t, int, hash, compare>>(
+        "open_hash_table", key_name, order, keys, options, results);
+    bench_structure<
+        open_hash_table<key_t, int, hash, compare, robin_hood_hashing>>(
+        "robin_hood_hash_table", key_name, order, keys, options, results);
+    bench_structure<swiss_hash_table<key_t, int, hash, compare>>(
+        "swiss_hash_table", key_name, order, keys, options, results);
+}
+
+// Mede a collation e o hash isoladamente, sem nenhuma estrutura: o cálculo
+// das sort keys, a comparação direta pelo Collator e o hash das palavras
+void bench_baselines(const vector<UnicodeString> &words,
+                     const micro_options &options,
+                     vector<micro_result> &results) {
+    sort_key_compare compare;
+    hash_unicode hashing;
+    vector<long long> sort_key_times, collator_times, hash_times;
+
+    for (unsigned int rep = 0; rep < options.repetitions; rep++) {
+        vector<collation_key> keys(words.begin(), words.end());
+        size_t total = 0;  // Evita que o compilador descarte os cálculos
+
+        sort_key_times.push_back(measure_ns([&] {
+            for (const collation_key &k : keys) {
+                total += compare.sort_key(k).size();
+            }
+        }));
+
+        collator_times.push_back(measure_ns([&] {
+            for (size_t i = 1; i < words.size(); i++) {
+                total += compare.collator->compare(words[i - 1], words[i]);
+            }
+        }));
+
+        hash_times.push_back(measure_ns([&] {
+            for (const UnicodeString &w : words) {
+                total += hashing(w);
+            }
+        }));
+
+        if (total == 0) {
+            cerr << "Error: Unexpected empty baseline" << endl;
+        }
+    }
+
+    const pair<string, vector<long long> *> baselines[] = {
+        {"collator_sort_key", &sort_key_times},
+        {"collator_compare", &collator_times},
+        {"hash", &hash_times}};
+    for (const auto &b : baselines) {
+        sort(b.second->begin(), b.second->end());
+        results.push_back(micro_result{"baseline", "unicode", "uniform",
+                                       b.first, words.size(),
+                                       b.second->front(),
+                                       percentile(*b.second, 50)});
+    }
+}
+
+// Função para exibir o uso correto do microbenchmark
+void display_micro_usage(const char *program_name) {
+    cerr << "Uso: " << program_name << " [opções]" << endl;
+    cerr << "Opções:" << endl;
+    cerr << "  --size N     número de chaves distintas (padrão 50000)" << endl;
+    cerr << "  --reps N     execuções medidas de cada operação (padrão 5)"
+         << endl;
+    cerr << "  --format F   formato da saída: csv ou json (padrão csv)" << endl;
+    cerr << "  --output F   escreve o resultado em F em vez da saída padrão"
+         << endl;
+}
+
+// Lê as opções do microbenchmark, retornando false se alguma for inválida
+bool parse_micro_options(int argc, char *argv[], micro_options &options) {
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Error: Missing value for option " << option << endl;
+            return false;
+        }
+
+        string value = argv[++i];
+        bool valid = true;
+        if (option == "--size") {
+            valid = parse_number(value.c_str(), options.size);
+        } else if (option == "--reps") {
+            valid = parse_number(value.c_str(), options.repetitions);
+        } else if (option == "--format") {
+            valid = value == "csv" || value == "json";
+            options.format = value;
+        } else if (option == "--output") {
+            options.output = value;
+        } else {
+            cerr << "Error: Invalid option " << option << endl;
+            return false;
+        }
+
+        if (!valid) {
+            cerr << "Error: Invalid value " << value << " for option "
+                 << option << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Escreve os resultados em CSV, uma linha por operação
+void write_csv(ostream &out, const vector<micro_result> &results) {
+    out << fixed << setprecision(2);
+    out << "structure,key,order,operation,operations,min_ns,median_ns,"
+           "ns_per_op\n";
+    for (const auto &r : results) {
+        out << r.structure << ',' << r.key << ',' << r.order << ','
+            << r.operation << ',' << r.operations << ',' << r.min_ns << ','
+            << r.median_ns << ',' << r.ns_per_operation() << '\n';
+    }
+}
+
+// Escreve os resultados em JSON, como uma lista de objetos
+void write_json(ostream &out, const vector<micro_result> &results) {
+    out << fixed << setprecision(2);
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto &r = results[i];
+        out << "  {\"structure\": \"" << r.structure << "\", \"key\": \""
+            << r.key << "\", \"order\": \"" << r.order
+            << "\", \"operation\": \"" << r.operation
+            << "\", \"operations\": " << r.operations
+            << ", \"min_ns\": " << r.min_ns
+            << ", \"median_ns\": " << r.median_ns
+            << ", \"ns_per_op\": " << r.ns_per_operation() << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+}
+
+int main(int argc, char *argv[]) {
+    micro_options options;
+    if (!parse_micro_options(argc, argv, options)) {
+        display_micro_usage(argv[0]);
+        return 1;
+    }
+
+    vector<micro_result> results;
+    mt19937_64 rng(42);  // Semente fixa para medições reproduzíveis
+
+    // Chaves UnicodeString: a primeira metade das palavras é inserida e a
+    // segunda metade é usada nas buscas sem sucesso. As palavras adversárias
+    // têm um prefixo longo em comum, o que encarece as comparações
+    vector<UnicodeString> words = generate_words(2 * options.size, "", rng);
+    vector<UnicodeString> long_words = generate_words(
+        2 * options.size, UnicodeString::fromUTF8("anticonstitucionalmente"),
+        rng);
+    bench_baselines(words, options, results);
+
+    auto unicode_orders = build_orders<collation_key>(
+        vector<collation_key>(words.begin(), words.begin() + options.size),
+        vector<collation_key>(words.begin() + options.size, words.end()),
+        vector<collation_key>(long_words.begin(),
+                              long_words.begin() + options.size),
+        vector<collation_key>(long_words.begin() + options.size,
+                              long_words.end()),
+        sort_key_compare(), rng);
+    for (const auto &order : unicode_orders) {
+        bench_all_structures<collation_key, hash_unicode, sort_key_compare>(
+            "unicode", order.first, order.second, options, results);
+    }
+
+    // Chaves inteiras: medem a estrutura sem o custo da collation. As chaves
+    // adversárias só diferem nos bits altos
+    vector<int64_t> integers = generate_integers(2 * options.size, false, rng);
+    vector<int64_t> high = generate_integers(2 * options.size, true, rng);
+    auto integer_orders = build_orders<int64_t>(
+        vector<int64_t>(integers.begin(), integers.begin() + options.size),
+        vector<int64_t>(integers.begin() + options.size, integers.end()),
+        vector<int64_t>(high.begin(), high.begin() + options.size),
+        vector<int64_t>(high.begin() + options.size, high.end()),
+        less<int64_t>(), rng);
+    for (const auto &order : integer_orders) {
+        bench_all_structures<int64_t, std::hash<int64_t>, less<int64_t>>(
+            "int", order.first, order.second, options, results);
+    }
+
+    // Escreve o resultado no arquivo pedido ou na saída padrão
+    ofstream output_file;
+    if (!options.output.empty()) {
+        output_file.open(options.output);
+        if (!output_file.is_open()) {
+            cerr << "Error: Could not open file " << options.output << endl;
+            return 1;
+        }
+    }
+    ostream &out = options.output.empty() ? cout : output_file;
+
+    if (options.format == "json") {
+        write_json(out, results);
+    } else {
+        write_csv(out, results);
+    }
+    return 0;
+}
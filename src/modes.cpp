@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../include/avl_tree/avl_tree.hpp"
+#include "../include/compare.hpp"
+#include "../include/dictionary.hpp"
+#include "../include/interned_word.hpp"
+#include "../include/hash_table/chained_hash_table.hpp"
+#include "../include/hash_table/open_hash_table.hpp"
+#include "../include/hash_table/swiss_hash_table.hpp"
+#include "../include/rb_tree/red_black_tree.hpp"
+#include "utils.cpp"
+
+// Modos de estrutura aceitos pelo programa, na ordem em que são listados
+const std::vector<std::string> dictionary_modes = {
+    "dictionary_avl",
+    "dictionary_rb",
+    "dictionary_chained_hash",
+    "dictionary_open_hash",
+    "dictionary_robin_hood_hash",
+    "dictionary_swiss_hash",
+};
+
+// Cria um dicionário vazio com a estrutura do modo dado e chama f(dict). As
+// estruturas guardam as palavras internadas em uma arena (interned_word).
+// Retorna false se o modo não existir
+template <typename function>
+bool with_dictionary(const std::string& mode_structure, function f) {
+    // Dicionário utilizando uma árvore AVL
+    if (mode_structure == "dictionary_avl") {
+        dictionary<avl_tree<interned_word, int, interned_compare>> dict;
+        f(dict);
+    }
+
+    // Dicionário utilizando uma árvore rubro-negra
+    else if (mode_structure == "dictionary_rb") {
+        dictionary<red_black_tree<interned_word, int, interned_compare>> dict;
+        f(dict);
+    }
+
+    // Dicionário utilizando uma tabela hash com encadeamento exterior
+    else if (mode_structure == "dictionary_chained_hash") {
+        dictionary<chained_hash_table<interned_word, int, interned_hash,
+                                      interned_compare>>
+            dict;
+        f(dict);
+    }
+
+    // Dicionário utilizando tabela hash com endereçamento aberto
+    else if (mode_structure == "dictionary_open_hash") {
+        dictionary<open_hash_table<interned_word, int, interned_hash,
+                                   interned_compare>>
+            dict;
+        f(dict);
+    }
+
+    // Dicionário utilizando tabela hash com endereçamento aberto e sondagem
+    // linear Robin Hood (remoção com deslocamento para trás)
+    else if (mode_structure == "dictionary_robin_hood_hash") {
+        dictionary<open_hash_table<interned_word, int, interned_hash,
+                                   interned_compare, robin_hood_hashing>>
+            dict;
+        f(dict);
+    }
+
+    // Dicionário utilizando tabela hash com endereçamento aberto no estilo
+    // Swiss table (bytes de controle sondados em grupos com SSE2)
+    else if (mode_structure == "dictionary_swiss_hash") {
+        dictionary<swiss_hash_table<interned_word, int, interned_hash,
+                                    interned_compare>>
+            dict;
+        f(dict);
+    }
+
+    else {
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,174 @@
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "modes.cpp"
+#include "utils.cpp"
+
+using namespace std;
+
+// Testes de regressão do dicionário. Cada teste roda com todas as estruturas
+// e registra as falhas com check(); o programa retorna 1 se algum falhar.
+
+int failures = 0;  // Número de verificações que falharam
+
+// Registra uma falha, com a estrutura e a descrição, se cond for falso
+void check(bool cond, const string &mode, const string &description) {
+    if (!cond) {
+        cerr << "FALHA [" << mode << "] " << description << endl;
+        failures++;
+    }
+}
+
+// Retorna o caminho de um arquivo temporário para os snapshots dos testes
+string temp_path(const string &name) {
+    return (filesystem::temp_directory_path() / name).string();
+}
+
+// Retorna a frequência de word na listagem em ordem do dicionário (begin/end
+// das estruturas), ou -1 se a palavra não aparecer
+template <typename dict_type>
+int listed_count(dict_type &dict, const string &word) {
+    string list;
+    dict.list().toUTF8String(list);
+    string prefix = "\"" + word + "\" - ";
+    size_t p = list.find("\n" + prefix);
+    if (list.compare(0, prefix.size(), prefix) == 0) {
+        p = 0;
+    } else if (p == string::npos) {
+        return -1;
+    } else {
+        p++;
+    }
+    return stoi(list.substr(p + prefix.size()));
+}
+
+// Carrega um snapshot e insere de novo as mesmas palavras: as frequências
+// novas devem aparecer na listagem e no snapshot salvo em seguida (as tabelas
+// hash não podem listar a cópia ordenada montada no carregamento)
+void test_snapshot_then_ingest() {
+    const string text = "o menino sozinho e o cão sozinho";
+    const string first = temp_path("dictionary_test_first.bin");
+    const string second = temp_path("dictionary_test_second.bin");
+
+    for (const string &mode : dictionary_modes) {
+        with_dictionary(mode, [&](auto &dict) {
+            dict.insert_utf8(text.data(), text.size());
+            dict.save_snapshot(first);
+
+            dict.load_snapshot(first);
+            dict.insert_utf8(text.data(), text.size());
+            check(listed_count(dict, "sozinho") == 4, mode,
+                  "listagem depois de carregar e inserir");
+            check(listed_count(dict, "menino") == 2, mode,
+                  "palavra já existente com frequência 1");
+
+            dict.save_snapshot(second);
+            dict.load_snapshot(second);
+            check(dict.search(UnicodeString::fromUTF8("sozinho")) == 4, mode,
+                  "snapshot salvo depois de carregar e inserir");
+            check(dict.size() == 5, mode, "tamanho do dicionário");
+        });
+    }
+
+    filesystem::remove(first);
+    filesystem::remove(second);
+}
+
+// Um snapshot salvo com um locale e carregado com outro (em que a ordem das
+// palavras é diferente) não pode ser usado como se estivesse ordenado: depois
+// de inserir as mesmas palavras, cada uma deve aparecer uma única vez, na
+// ordem do locale atual
+void test_snapshot_other_locale() {
+    const string text = "zebra ärlig öl apa";
+    const string path = temp_path("dictionary_test_locale.bin");
+    UErrorCode status = U_ZERO_ERROR;
+    Locale original = Locale::getDefault();
+
+    for (const string &mode : dictionary_modes) {
+        Locale::setDefault(Locale("en_US"), status);
+        with_dictionary(mode, [&](auto &dict) {
+            dict.insert_utf8(text.data(), text.size());
+            dict.save_snapshot(path);
+        });
+
+        // Em sueco, "ä" e "ö" vêm depois de "z"
+        Locale::setDefault(Locale("sv_SE"), status);
+        with_dictionary(mode, [&](auto &dict) {
+            dict.load_snapshot(path);
+            dict.insert_utf8(text.data(), text.size());
+            string list;
+            dict.list().toUTF8String(list);
+            check(list == "\"apa\" - 2\n\"zebra\" - 2\n\"ärlig\" - 2\n"
+                          "\"öl\" - 2\n",
+                  mode, "snapshot de outro locale");
+        });
+    }
+
+    Locale::setDefault(original, status);
+    filesystem::remove(path);
+}
+
+// Retorna as frequências das palavras do texto, entregue ao tokenizador em
+// pedaços de piece bytes
+map<string, int> tokenize(const string &text, size_t piece) {
+    map<string, int> words;
+    auto emit = [&](const UnicodeString &word) {
+        string utf8;
+        words[word.toUTF8String(utf8)]++;
+    };
+    utf8_tokenizer tokenizer;
+    for (size_t i = 0; i < text.size(); i += piece) {
+        tokenizer.feed(text.data() + i, min(piece, text.size() - i), emit);
+    }
+    tokenizer.finish(emit);
+    return words;
+}
+
+// Um texto maior que as partes internas do tokenizador, entregue de uma vez
+// (como com --mmap), deve ter as mesmas palavras que entregue em pedaços
+// pequenos, inclusive um caractere dividido entre duas partes
+void test_large_feed() {
+    string text;
+    while (text.size() < (1 << 20) - 2) {
+        text += "palavra ";
+    }
+    text.resize((1 << 20) - 3);
+    text += ' ';
+    text += "ação ";  // "ç" começa no último byte da primeira parte
+    while (text.size() < 3 * (1 << 20)) {
+        text += "coração e razão ";
+    }
+
+    map<string, int> whole = tokenize(text, text.size());
+    check(whole == tokenize(text, 7), "tokenizer", "feed em um único pedaço");
+    check(whole["ação"] == 1, "tokenizer", "caractere dividido entre partes");
+}
+
+// As palavras com caracteres não ASCII usam o mapeamento completo de caixa,
+// que depende do contexto: o sigma maiúsculo no fim da palavra vira o sigma
+// final, e "İ" vira "i" seguido do ponto combinante (U+0307)
+void test_full_case_mapping() {
+    map<string, int> words = tokenize("ΣΣ ΟΔΟΣ-ΣΟΦΙΑ İstanbul AÇÃO", 1);
+    check(words["σς"] == 1, "tokenizer", "sigma final");
+    check(words["οδος-σοφια"] == 1, "tokenizer", "sigma final antes de hífen");
+    check(words["i\u0307stanbul"] == 1, "tokenizer", "I maiúsculo com ponto");
+    check(words["ação"] == 1, "tokenizer", "letras latinas acentuadas");
+    check(words.size() == 4, "tokenizer", "número de palavras");
+}
+
+int main() {
+    test_snapshot_then_ingest();
+    test_snapshot_other_locale();
+    test_large_feed();
+    test_full_case_mapping();
+
+    if (failures > 0) {
+        cerr << failures << " verificações falharam" << endl;
+        return 1;
+    }
+    cout << "Todos os testes passaram" << endl;
+    return 0;
+}
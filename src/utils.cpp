@@ -6,67 +6,131 @@
 #include <unicode/ustream.h>
 
 #include <chrono>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "../include/avl_tree/avl_tree.hpp"
 #include "../include/dictionary.hpp"
+#include "../include/mapped_file.hpp"
+#include "../include/phase_timer.hpp"
 
 using namespace std;
 using namespace icu;
 using namespace std::chrono;
 
-// Formata a UnicodeString para minúsculas e remove quaisquer caracteres que não
-// sejam alfanuméricos ou hífen
-
-void format_text(UnicodeString &text) {
-    // Converte o texto para minúsculas, remove caracteres não alfanuméricos e
-    // remove hífens que não sejam entre palavras.
-
-    // Converte o texto para minúsculas
-    text.toLower();
-
-    // Itera sobre cada caractere na string `text`.
-    for (int i = 0; i < text.length(); i++) {
-        // Obtém o caractere atual.
-        UChar character = text[i];
-
-        // Verifica se o caractere não é alfanumérico.
-        if (!u_isalpha(character)) {
-            // Verifica se o caractere atual é um hífen entre duas palavras
-            // alfanuméricas.
-            bool is_hyphen_between_words =
-                (character == '-') && (i > 0 && u_isalpha(text[i - 1])) &&
-                (i < text.length() - 1 && u_isalpha(text[i + 1]));
-
-            // Se o hífen não estiver entre duas palavras, substitui o caractere
-            // por um espaço.
-            if (!is_hyphen_between_words) {
-                text.replace(i, 1, ' ');
-            }
+// Abre um arquivo de texto em UTF-8 e insere as suas palavras no dicionário,
+// lendo o arquivo em blocos (sem carregar o arquivo inteiro em memória)
+template <typename dict_type>
+void read_file(const string &file_path, dict_type &dict) {
+    // Abre o arquivo
+    ifstream input_file(file_path, ios::binary);
+    if (!input_file.is_open()) {
+        cerr << "Error: Could not open file " << file_path << endl;
+        exit(1);
+    }
+
+    // Formata o conteúdo do arquivo e insere as palavras no dicionário
+    dict.insert_stream(input_file);
+}
+
+// Mapeia um arquivo de texto em UTF-8 na memória (mmap) e insere as suas
+// palavras no dicionário, lendo diretamente das páginas mapeadas
+template <typename dict_type>
+void read_file_mmap(const string &file_path, dict_type &dict) {
+    // Abre e mapeia o arquivo
+    mapped_file input_file(file_path);
+    if (!input_file.is_open()) {
+        cerr << "Error: Could not open file " << file_path << endl;
+        exit(1);
+    }
+
+    // Formata o conteúdo do arquivo e insere as palavras no dicionário
+    dict.insert_utf8(input_file.data(), input_file.size());
+}
+
+// Divide o texto em até n pedaços de tamanhos próximos, retornando os limites
+// dos pedaços. Os cortes são feitos apenas em espaços em branco ASCII, que
+// sempre separam palavras e nunca fazem parte de uma sequência UTF-8 maior
+vector<size_t> split_text(const char *data, size_t size, unsigned int n) {
+    vector<size_t> bounds = {0};
+    for (unsigned int i = 1; i < n; i++) {
+        // Começa no corte ideal e avança até o próximo espaço em branco
+        size_t cut = max(bounds.back(), size / n * i);
+        while (cut < size && data[cut] != ' ' && data[cut] != '\n' &&
+               data[cut] != '\r' && data[cut] != '\t') {
+            cut++;
+        }
+        if (cut > bounds.back() && cut < size) {
+            bounds.push_back(cut);
         }
     }
+    bounds.push_back(size);
+    return bounds;
 }
 
-// Retorna uma stringstream com as palavras de um arquivo de texto formatadas
-UnicodeString read_file(const string &file_path) {
-    // Abre o arquivo
+// Retorna o número máximo de threads da contagem: quatro por núcleo. Mais
+// threads que isso só aumentam a memória dos dicionários parciais, e um
+// número muito grande faria a criação das threads falhar
+unsigned int max_threads() {
+    unsigned int cores = thread::hardware_concurrency();
+    return 4 * (cores > 0 ? cores : 1);
+}
+
+// Conta as palavras do texto usando várias threads: o texto é dividido em
+// pedaços, cada thread conta o seu pedaço em um dicionário próprio (com o seu
+// próprio functor de comparação) e os resultados são somados no dicionário.
+// São usadas no máximo max_threads() threads, uma por pedaço
+template <typename dict_type>
+void insert_parallel(dict_type &dict, const char *data, size_t size,
+                     unsigned int threads) {
+    threads = min(threads, max_threads());
+    vector<size_t> bounds = split_text(data, size, threads);
+    vector<dict_type> partial(bounds.size() - 1);
+
+    // Conta cada pedaço em uma thread separada
+    vector<thread> workers;
+    for (size_t i = 0; i < partial.size(); i++) {
+        workers.emplace_back([&, i]() {
+            partial[i].insert_utf8(data + bounds[i], bounds[i + 1] - bounds[i]);
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    // Junta os dicionários parciais no dicionário final
+    for (auto &p : partial) {
+        dict.merge(p);
+    }
+}
+
+// Lê o arquivo inteiro (com mmap ou para uma string) e conta as suas palavras
+// usando várias threads
+template <typename dict_type>
+void read_file_parallel(const string &file_path, dict_type &dict,
+                        unsigned int threads, bool use_mmap) {
+    if (use_mmap) {
+        mapped_file input_file(file_path);
+        if (!input_file.is_open()) {
+            cerr << "Error: Could not open file " << file_path << endl;
+            exit(1);
+        }
+        insert_parallel(dict, input_file.data(), input_file.size(), threads);
+        return;
+    }
+
     ifstream input_file(file_path, ios::binary);
     if (!input_file.is_open()) {
         cerr << "Error: Could not open file " << file_path << endl;
         exit(1);
     }
-
-    // Salva o conteúdo do arquivo em uma string e converte para UnicodeString
     string file_content((istreambuf_iterator<char>(input_file)),
                         istreambuf_iterator<char>());
-    UnicodeString unicode_content =
-        UnicodeString::fromUTF8(StringPiece(file_content));
-
-    // Formata e retorna o conteúdo do arquivo
-    format_text(unicode_content);
-    return unicode_content;
+    insert_parallel(dict, file_content.data(), file_content.size(), threads);
 }
 
 void write_file(const std::string &file_path, const std::string &content) {
@@ -81,24 +145,153 @@ void write_file(const std::string &file_path, const std::string &content) {
     output_file.close();
 }
 
+// Retorna o pico de memória residente (RSS) do processo em KiB, lido do campo
+// VmHWM de /proc/self/status, ou 0 se não estiver disponível
+size_t peak_rss_kib() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return strtoul(line.c_str() + 6, nullptr, 10);
+        }
+    }
+    return 0;
+}
+
 // Função para exibir o uso correto do programa
 void display_usage(const char *program_name) {
     cerr << "Uso: " << program_name
-         << " <modo_estrutura> <arquivo(deve estar na pasta in)>" << endl;
+         << " <modo_estrutura> [arquivos(devem estar na pasta in)...] "
+            "[opções]"
+         << endl;
     cerr << "Modos de estrutura: dictionary_avl, dictionary_rb, "
-            "dictionary_chained_hash"
+            "dictionary_chained_hash, dictionary_open_hash, "
+            "dictionary_robin_hood_hash, dictionary_swiss_hash"
+         << endl;
+    cerr << "Opções:" << endl;
+    cerr << "  --mmap             lê o arquivo de entrada mapeando-o na "
+            "memória"
+         << endl;
+    cerr << "  --threads N        conta as palavras usando N threads (no "
+            "máximo 4 por núcleo)"
+         << endl;
+    cerr << "  --timings F        salva os tempos de cada etapa em JSON no "
+            "arquivo F"
+         << endl;
+    cerr << "  --stats            mostra os histogramas de sondagens, buckets "
+            "ou profundidade"
+         << endl;
+    cerr << "  --save-snapshot F  salva o dicionário em um snapshot binário "
+            "no arquivo F"
+         << endl;
+    cerr << "  --load-snapshot F  começa do dicionário do snapshot F e soma os "
+            "arquivos (repetida, junta os snapshots)"
+         << endl;
+    cerr << "  --top N            salva apenas as N palavras mais frequentes"
          << endl;
 }
 
-template <typename dict_type>
-void process_and_save_dict(dict_type &dict, const string &filename,
-                           const string &mode_structure) {
-    // Processa o arquivo
-    UnicodeString file = read_file("in/" + filename);
+// Opções de execução passadas pela linha de comando
+struct program_options {
+    bool use_mmap = false;     // Lê o arquivo de entrada com mmap
+    unsigned int threads = 1;  // Número de threads usadas na contagem
+    string timings_file;       // Arquivo JSON com os tempos (vazio = nenhum)
+    bool show_stats = false;   // Mostra as estatísticas da estrutura
+    string save_snapshot;      // Snapshot binário a salvar (vazio = nenhum)
+    size_t top = 0;            // Palavras mais frequentes a salvar (0 = todas)
+
+    // Snapshots binários a carregar e juntar, na ordem (vazio = nenhum)
+    vector<string> load_snapshots;
+};
+
+// Lê as opções a partir de argv[first], retornando false se alguma opção for
+// inválida
+bool parse_options(int argc, char *argv[], int first,
+                   program_options &options) {
+    for (int i = first; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--mmap") {
+            options.use_mmap = true;
+        } else if (option == "--threads" && i + 1 < argc) {
+            char *end;
+            long threads = strtol(argv[++i], &end, 10);
+            if (end == argv[i] || *end != '\0' || threads < 1) {
+                cerr << "Error: Invalid number of threads " << argv[i] << endl;
+                return false;
+            }
+            options.threads = static_cast<unsigned int>(
+                min(threads, static_cast<long>(max_threads())));
+        } else if (option == "--top" && i + 1 < argc) {
+            char *end;
+            long top = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || top < 1) {
+                cerr << "Error: Invalid number of words " << argv[i] << endl;
+                return false;
+            }
+            options.top = static_cast<size_t>(top);
+        } else if (option == "--stats") {
+            options.show_stats = true;
+        } else if (option == "--timings" && i + 1 < argc) {
+            options.timings_file = argv[++i];
+        } else if (option == "--save-snapshot" && i + 1 < argc) {
+            options.save_snapshot = argv[++i];
+        } else if (option == "--load-snapshot" && i + 1 < argc) {
+            options.load_snapshots.push_back(argv[++i]);
+        } else {
+            cerr << "Error: Invalid option " << option << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Retorna o nome usado no arquivo de saída: o primeiro arquivo de entrada
+// ou, sem arquivos de entrada, o nome do primeiro snapshot com extensão .txt
+string output_name(const vector<string> &filenames,
+                   const program_options &options) {
+    if (!filenames.empty()) {
+        return filenames[0];
+    }
+    string name = options.load_snapshots[0];
+    name = name.substr(name.find_last_of('/') + 1);
+    return name.substr(0, name.find_last_of('.')) + ".txt";
+}
 
-    // Inicia a contagem do tempo e insere as palavras no dicionário
+template <typename dict_type>
+void process_and_save_dict(dict_type &dict, const vector<string> &filenames,
+                           const string &mode_structure,
+                           const program_options &options) {
+    // Inicia a contagem do tempo e monta o dicionário. Com snapshots, o
+    // dicionário começa do primeiro e os demais são somados a ele por
+    // merge-join; os arquivos de entrada são então somados por cima, então o
+    // custo de uma atualização é proporcional apenas ao texto novo
+    phase_timer timer;
     auto start = high_resolution_clock::now();
-    dict.insert_text(file);
+    if (!options.load_snapshots.empty()) {
+        timer.measure("carregamento do snapshot", [&] {
+            dict.load_snapshot(options.load_snapshots[0]);
+            for (size_t i = 1; i < options.load_snapshots.size(); i++) {
+                dict.merge_snapshot(options.load_snapshots[i]);
+            }
+        });
+    }
+
+    // A leitura, a tokenização e a inserção são feitas em uma única passada
+    // sobre o texto, então são medidas como uma só etapa
+    if (!filenames.empty()) {
+        timer.measure("leitura e contagem", [&] {
+            for (const string &filename : filenames) {
+                if (options.threads > 1) {
+                    read_file_parallel("in/" + filename, dict,
+                                       options.threads, options.use_mmap);
+                } else if (options.use_mmap) {
+                    read_file_mmap("in/" + filename, dict);
+                } else {
+                    read_file("in/" + filename, dict);
+                }
+            }
+        });
+    }
 
     // Finaliza a contagem do tempo e calcula a duração
     auto stop = high_resolution_clock::now();
@@ -107,9 +300,35 @@ void process_and_save_dict(dict_type &dict, const string &filename,
     cout << "Tempo de execução: " << duration.count() << "ms" << endl;
     // cout << dict.comparisons() << " comparações" << endl;
 
-    // Salva o dicionário no arquivo
-    string out_filename = "out/" + mode_structure + "_" + filename;
-    dict.save(out_filename, duration);
+    // Salva o dicionário no arquivo ou, com --top, apenas as palavras mais
+    // frequentes, sem ordenar as chaves pela collation
+    if (options.top > 0) {
+        string out_filename = "out/" + mode_structure + "_top" +
+                              to_string(options.top) + "_" +
+                              output_name(filenames, options);
+        dict.save_top(out_filename, options.top, duration, timer);
+    } else {
+        string out_filename =
+            "out/" + mode_structure + "_" + output_name(filenames, options);
+        dict.save(out_filename, duration, timer);
+    }
+    cout << "Pico de memória (RSS): " << peak_rss_kib() << " KiB" << endl;
+
+    // Salva o snapshot binário, se pedido
+    if (!options.save_snapshot.empty()) {
+        timer.measure("escrita do snapshot",
+                      [&] { dict.save_snapshot(options.save_snapshot); });
+    }
+
+    // Mostra os histogramas da estrutura, se pedido
+    if (options.show_stats) {
+        cout << dict.stats().report();
+    }
+
+    // Salva os tempos de cada etapa em JSON, se pedido
+    if (!options.timings_file.empty()) {
+        write_file(options.timings_file, timer.to_json());
+    }
 }
 
 struct hash_unicode {